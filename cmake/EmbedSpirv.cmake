@@ -0,0 +1,41 @@
+# Writes the SPIR-V files in SPIRV_FILES (separated by |) to OUTPUT as C++ word arrays,
+# listed in vkEngine::g_EmbeddedShaders under their file names.
+# usage: cmake -DSPIRV_FILES=a.spv|b.spv -DOUTPUT=file.cpp -P EmbedSpirv.cmake
+
+string(REPLACE "|" ";" SPIRV_FILES "${SPIRV_FILES}")
+
+set(CONTENT "// generated by cmake/EmbedSpirv.cmake, do not edit\n\n#include <vkEmbeddedShaders.h>\n\n")
+set(ENTRIES "")
+set(INDEX 0)
+
+foreach(SPIRV ${SPIRV_FILES})
+  if(NOT EXISTS ${SPIRV})
+    message(WARNING "${SPIRV} does not exist, it will not be embedded")
+    continue()
+  endif()
+
+  get_filename_component(FILE_NAME ${SPIRV} NAME)
+  file(READ ${SPIRV} HEX_CONTENT HEX)
+  string(LENGTH "${HEX_CONTENT}" HEX_LENGTH)
+  math(EXPR BYTE_COUNT "${HEX_LENGTH} / 2")
+
+  ## SPIR-V is little endian words, turn every four bytes into one word literal
+  string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])" "0x\\4\\3\\2\\1," WORDS "${HEX_CONTENT}")
+  ## and break the lines every eight words
+  string(REGEX REPLACE "(0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,)" "\\1\n\t" WORDS "${WORDS}")
+  string(REGEX REPLACE "\n\t$" "" WORDS "${WORDS}")
+
+  string(APPEND CONTENT "static const uint32_t shader${INDEX}[] = {\n\t${WORDS}\n};\n\n")
+  string(APPEND ENTRIES "\t{ \"${FILE_NAME}\", shader${INDEX}, ${BYTE_COUNT} },\n")
+  math(EXPR INDEX "${INDEX} + 1")
+endforeach()
+
+string(APPEND CONTENT "const vkEngine::EmbeddedShader vkEngine::g_EmbeddedShaders[] = {\n${ENTRIES}\t{ nullptr, nullptr, 0 }\n};\n")
+
+## only touch the output when it changed, so unchanged shaders do not relink the engine
+if(EXISTS ${OUTPUT})
+  file(READ ${OUTPUT} PREVIOUS_CONTENT)
+endif()
+if(NOT "${PREVIOUS_CONTENT}" STREQUAL "${CONTENT}")
+  file(WRITE ${OUTPUT} "${CONTENT}")
+endif()
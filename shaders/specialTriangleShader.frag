@@ -1,9 +0,0 @@
-#version 450
-
-layout (location = 0) out vec4 outFragColor;
-
-
-void main()
-{
-	outFragColor = vec4(0.1f,0.2f,0.4f,1.0f);
-}
\ No newline at end of file
@@ -4,7 +4,13 @@ layout (location = 0) out vec4 outFragColor;
 
 layout (location = 0) in vec3 inColor;
 
+//picked per pipeline through VkSpecializationInfo, each variant only keeps its own branch
+layout (constant_id = 0) const bool FLAT_COLOR = false;
+
 void main()
 {
-	outFragColor = vec4(inColor,1.0f);
+	if (FLAT_COLOR)
+		outFragColor = vec4(0.1f,0.2f,0.4f,1.0f);
+	else
+		outFragColor = vec4(inColor,1.0f);
 }
\ No newline at end of file
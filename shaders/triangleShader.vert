@@ -3,6 +3,12 @@
 
 layout (location = 0) out vec3 outColor;
 
+//rewritten right before the frame is submitted with the newest input, see VulkanEngine::latch_frame_uniforms
+layout (set = 0, binding = 0) uniform FrameUniforms
+{
+	mat4 transform;
+} frameData;
+
 void main()
 {
 	//const array of positions for the triangle
@@ -22,5 +28,5 @@ void main()
 
 	outColor = colors[gl_VertexIndex];
 	//output the position of each vertex
-	gl_Position = vec4(positions[gl_VertexIndex], 1.0f);
+	gl_Position = frameData.transform * vec4(positions[gl_VertexIndex], 1.0f);
 }
\ No newline at end of file
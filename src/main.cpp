@@ -1,14 +1,115 @@
 #include <vkEngine.h>
+#include <vkProfiler.h>
+
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+
+//frames rendered by a headless run when --frames is not given, there is no window to close
+constexpr uint64_t DEFAULT_HEADLESS_FRAMES = 1000;
+
+static bool parse_present_mode(const char* name, VkPresentModeKHR& outMode)
+{
+	if (strcmp(name, "fifo") == 0)
+		outMode = VK_PRESENT_MODE_FIFO_KHR;
+	else if (strcmp(name, "fifo-relaxed") == 0)
+		outMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+	else if (strcmp(name, "mailbox") == 0)
+		outMode = VK_PRESENT_MODE_MAILBOX_KHR;
+	else if (strcmp(name, "immediate") == 0)
+		outMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+	else
+		return false;
+	return true;
+}
 
 int main(int argc, char* argv[])
 {
+	vkEngine::EngineConfig config;
+	const char* benchmark = nullptr;
+	const char* tracePath = nullptr;
+
+	PROFILE_THREAD_NAME("main");
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+
+		if (strcmp(argv[i], "--headless") == 0)
+			config.headless = true;
+		else if (strcmp(argv[i], "--frames") == 0 && hasValue)
+			config.maxFrames = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--frames-in-flight") == 0 && hasValue)
+			config.framesInFlight = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--width") == 0 && hasValue)
+			config.windowExtent.width = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--height") == 0 && hasValue)
+			config.windowExtent.height = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--present-mode") == 0 && hasValue)
+		{
+			if (!parse_present_mode(argv[++i], config.presentMode))
+				std::cout << "Unknown present mode " << argv[i] << ", keeping FIFO" << std::endl;
+		}
+		else if (strcmp(argv[i], "--target-fps") == 0 && hasValue)
+		{
+			double fps = strtod(argv[++i], nullptr);
+			config.targetFrameTimeMs = fps > 0.0 ? 1000.0 / fps : 0.0;
+		}
+		else if (strcmp(argv[i], "--threaded") == 0)
+			config.threaded = true;
+		else if (strcmp(argv[i], "--async-present") == 0)
+			config.asyncPresent = true;
+		else if (strcmp(argv[i], "--no-late-latch") == 0)
+			config.lateLatch = false;
+		else if (strcmp(argv[i], "--serial-init") == 0)
+			config.parallelInit = false;
+		else if (strcmp(argv[i], "--shader-files") == 0)
+			config.embeddedShaders = false;
+		else if (strcmp(argv[i], "--hot-reload") == 0)
+			config.hotReload = true;
+		else if (strcmp(argv[i], "--pipeline-cache") == 0 && hasValue)
+			config.pipelineCachePath = argv[++i];
+		else if (strcmp(argv[i], "--no-pipeline-cache") == 0)
+			config.pipelineCachePath.clear();
+		else if (strcmp(argv[i], "--stats-csv") == 0 && hasValue)
+			config.statsCsvPath = argv[++i];
+		else if (strcmp(argv[i], "--stats-json") == 0 && hasValue)
+			config.statsJsonPath = argv[++i];
+		else if (strcmp(argv[i], "--trace") == 0 && hasValue)
+			tracePath = argv[++i];
+		else if (strcmp(argv[i], "--bench") == 0 && hasValue)
+			benchmark = argv[++i];
+		else
+			std::cout << "Ignoring unknown argument " << argv[i] << std::endl;
+	}
+
+	//benchmarks only need the device, and measure the driver rather than the validation layers
+	if (benchmark)
+	{
+		config.headless = true;
+		config.validation = false;
+	}
+
+	if (config.headless && config.maxFrames == 0)
+		config.maxFrames = DEFAULT_HEADLESS_FRAMES;
+
 	vkEngine::VulkanEngine engine;
 
-	engine.init();	
-	
-	engine.run();	
+	engine.init(config);
+
+	if (benchmark)
+	{
+		if (!engine.run_benchmark(benchmark))
+			std::cout << "Unknown benchmark " << benchmark << std::endl;
+	}
+	else
+		engine.run();
+
+	engine.cleanup();
 
-	engine.cleanup();	
+	//every thread that records has been joined by now
+	if (tracePath)
+		vkEngine::profiler::write_chrome_trace(tracePath);
 
 	return 0;
 }
@@ -0,0 +1,196 @@
+#include <vkBenchmark.h>
+#include <vkDeletionQueue.h>
+
+#include <iostream>
+#include <chrono>
+#include <deque>
+
+using BenchClock = std::chrono::steady_clock;
+
+static double elapsed_ms(BenchClock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+//the queue as it was before typed records, kept here as the baseline
+struct ClosureQueue
+{
+	void push_function(std::function<void()>&& function)
+	{
+		deletors.push_back(function);
+	}
+
+	void flush()
+	{
+		for (auto it = deletors.rbegin(); it != deletors.rend(); it++) {
+			(*it)();
+		}
+
+		deletors.clear();
+	}
+
+	std::deque<std::function<void()>> deletors;
+};
+
+static void report(const char* name, uint32_t entryCount, double pushMs, double flushMs)
+{
+	std::cout << "  " << name << ": push " << pushMs << " ms (" << pushMs * 1e6 / entryCount << " ns/entry), flush "
+		<< flushMs << " ms (" << flushMs * 1e6 / entryCount << " ns/entry)" << std::endl;
+}
+
+void vkEngine::bench::deletion_queue(VkDevice device, uint32_t entryCount)
+{
+	std::cout << "Deletion queue benchmark, " << entryCount << " entries" << std::endl;
+
+	//destroying VK_NULL_HANDLE is a valid no-op, so every path pays the same driver call and only the queue differs.
+	//the entries cycle through three types so the typed path has batches to form
+	ClosureQueue legacy;
+	DeletionQueue closures;
+	DeletionQueue typed;
+
+	//the second pass shows the steady state, where the queues reuse the capacity of the first
+	for (int pass = 0; pass < 2; pass++)
+	{
+		std::cout << (pass == 0 ? " cold:" : " warm:") << std::endl;
+
+		auto start = BenchClock::now();
+		for (uint32_t i = 0; i < entryCount; i++)
+		{
+			switch (i % 3)
+			{
+			case 0: legacy.push_function([=]() { vkDestroySemaphore(device, VK_NULL_HANDLE, nullptr); }); break;
+			case 1: legacy.push_function([=]() { vkDestroyFence(device, VK_NULL_HANDLE, nullptr); }); break;
+			default: legacy.push_function([=]() { vkDestroyImageView(device, VK_NULL_HANDLE, nullptr); }); break;
+			}
+		}
+		double pushMs = elapsed_ms(start);
+		start = BenchClock::now();
+		legacy.flush();
+		report("std::deque closures", entryCount, pushMs, elapsed_ms(start));
+
+		start = BenchClock::now();
+		for (uint32_t i = 0; i < entryCount; i++)
+		{
+			switch (i % 3)
+			{
+			case 0: closures.push_function([=]() { vkDestroySemaphore(device, VK_NULL_HANDLE, nullptr); }); break;
+			case 1: closures.push_function([=]() { vkDestroyFence(device, VK_NULL_HANDLE, nullptr); }); break;
+			default: closures.push_function([=]() { vkDestroyImageView(device, VK_NULL_HANDLE, nullptr); }); break;
+			}
+		}
+		pushMs = elapsed_ms(start);
+		start = BenchClock::now();
+		closures.flush();
+		report("closure fallback   ", entryCount, pushMs, elapsed_ms(start));
+
+		start = BenchClock::now();
+		for (uint32_t i = 0; i < entryCount; i++)
+		{
+			switch (i % 3)
+			{
+			case 0: typed.push(device, (VkSemaphore)VK_NULL_HANDLE); break;
+			case 1: typed.push(device, (VkFence)VK_NULL_HANDLE); break;
+			default: typed.push(device, (VkImageView)VK_NULL_HANDLE); break;
+			}
+		}
+		pushMs = elapsed_ms(start);
+		start = BenchClock::now();
+		typed.flush();
+		report("typed records      ", entryCount, pushMs, elapsed_ms(start));
+	}
+}
+
+//the entry points the recording benchmark calls, filled from one of the dispatch paths
+struct RecordingFunctions
+{
+	PFN_vkResetCommandBuffer m_ResetCommandBuffer;
+	PFN_vkBeginCommandBuffer m_BeginCommandBuffer;
+	PFN_vkEndCommandBuffer m_EndCommandBuffer;
+	PFN_vkCmdBeginRenderPass m_CmdBeginRenderPass;
+	PFN_vkCmdEndRenderPass m_CmdEndRenderPass;
+	PFN_vkCmdSetViewport m_CmdSetViewport;
+	PFN_vkCmdSetScissor m_CmdSetScissor;
+	PFN_vkCmdBindPipeline m_CmdBindPipeline;
+	PFN_vkCmdBindDescriptorSets m_CmdBindDescriptorSets;
+	PFN_vkCmdDraw m_CmdDraw;
+};
+
+template<typename Loader>
+static RecordingFunctions load_recording_functions(Loader load)
+{
+	RecordingFunctions functions;
+	functions.m_ResetCommandBuffer = (PFN_vkResetCommandBuffer)load("vkResetCommandBuffer");
+	functions.m_BeginCommandBuffer = (PFN_vkBeginCommandBuffer)load("vkBeginCommandBuffer");
+	functions.m_EndCommandBuffer = (PFN_vkEndCommandBuffer)load("vkEndCommandBuffer");
+	functions.m_CmdBeginRenderPass = (PFN_vkCmdBeginRenderPass)load("vkCmdBeginRenderPass");
+	functions.m_CmdEndRenderPass = (PFN_vkCmdEndRenderPass)load("vkCmdEndRenderPass");
+	functions.m_CmdSetViewport = (PFN_vkCmdSetViewport)load("vkCmdSetViewport");
+	functions.m_CmdSetScissor = (PFN_vkCmdSetScissor)load("vkCmdSetScissor");
+	functions.m_CmdBindPipeline = (PFN_vkCmdBindPipeline)load("vkCmdBindPipeline");
+	functions.m_CmdBindDescriptorSets = (PFN_vkCmdBindDescriptorSets)load("vkCmdBindDescriptorSets");
+	functions.m_CmdDraw = (PFN_vkCmdDraw)load("vkCmdDraw");
+	return functions;
+}
+
+//records every round into the same command buffer and returns the fastest round in milliseconds
+static double record_rounds(const RecordingFunctions& vk, const vkEngine::bench::RecordingTarget& target, uint32_t drawCount, uint32_t rounds)
+{
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	//the engine's pipelines take viewport and scissor from the command buffer
+	VkViewport viewport = { 0.0f, 0.0f, (float)target.m_RenderPassInfo.renderArea.extent.width, (float)target.m_RenderPassInfo.renderArea.extent.height, 0.0f, 1.0f };
+
+	double bestMs = 0.0;
+	for (uint32_t round = 0; round < rounds; round++)
+	{
+		auto start = BenchClock::now();
+
+		vk.m_ResetCommandBuffer(target.m_CommandBuffer, 0);
+		vk.m_BeginCommandBuffer(target.m_CommandBuffer, &beginInfo);
+		vk.m_CmdBeginRenderPass(target.m_CommandBuffer, &target.m_RenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vk.m_CmdSetViewport(target.m_CommandBuffer, 0, 1, &viewport);
+		vk.m_CmdSetScissor(target.m_CommandBuffer, 0, 1, &target.m_RenderPassInfo.renderArea);
+		for (uint32_t i = 0; i < drawCount; i++)
+		{
+			vk.m_CmdBindPipeline(target.m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, target.m_Pipeline);
+			vk.m_CmdBindDescriptorSets(target.m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, target.m_PipelineLayout, 0, 1, &target.m_DescriptorSet, 0, nullptr);
+			vk.m_CmdDraw(target.m_CommandBuffer, 3, 1, 0, 0);
+		}
+		vk.m_CmdEndRenderPass(target.m_CommandBuffer);
+		vk.m_EndCommandBuffer(target.m_CommandBuffer);
+
+		double roundMs = elapsed_ms(start);
+		if (round == 0 || roundMs < bestMs)
+			bestMs = roundMs;
+	}
+
+	//leave the command buffer empty for whoever uses it next
+	vk.m_ResetCommandBuffer(target.m_CommandBuffer, 0);
+	return bestMs;
+}
+
+void vkEngine::bench::command_recording(VkInstance instance, VkDevice device, const RecordingTarget& target, bool validation, uint32_t drawCount, uint32_t rounds)
+{
+	//three commands per draw, plus the render pass begin and end and the viewport and scissor
+	uint64_t commandCount = 3ull * drawCount + 4;
+	std::cout << "Command recording benchmark, " << commandCount << " commands per round, best of " << rounds << " rounds" << std::endl;
+	//with the layers on both sets of pointers land in the layer first and the comparison says little about the loader
+	std::cout << "  validation layers: " << (validation ? "on" : "off") << std::endl;
+
+	//device commands queried from the instance are the loader's trampolines, which look up the device's dispatch table on every call
+	RecordingFunctions trampolines = load_recording_functions([=](const char* name) { return vkGetInstanceProcAddr(instance, name); });
+	//queried from the device they point straight into the driver when no layers are enabled, this is what volk loads for the engine
+	RecordingFunctions direct = load_recording_functions([=](const char* name) { return vkGetDeviceProcAddr(device, name); });
+
+	//warm up the command pool and the caches once, the rounds below reuse what it allocated
+	record_rounds(direct, target, drawCount, 1);
+
+	double trampolineMs = record_rounds(trampolines, target, drawCount, rounds);
+	double directMs = record_rounds(direct, target, drawCount, rounds);
+
+	std::cout << "  loader trampolines: " << trampolineMs << " ms (" << commandCount / (trampolineMs * 1e3) << " M commands/s)" << std::endl;
+	std::cout << "  device entry points: " << directMs << " ms (" << commandCount / (directMs * 1e3) << " M commands/s)" << std::endl;
+	std::cout << "  speedup: " << trampolineMs / directMs << "x" << std::endl;
+}
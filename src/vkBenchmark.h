@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vkTypes.h>
+
+namespace vkEngine {
+
+	//micro-benchmarks run through the engine's device instead of the main loop, selected with --bench
+	namespace bench {
+
+		//pushes and flushes entryCount null handles through the closure path and the typed path of the DeletionQueue
+		void deletion_queue(VkDevice device, uint32_t entryCount);
+
+		//what command_recording records into, a render pass with a pipeline that can draw inside it
+		struct RecordingTarget
+		{
+			VkCommandBuffer m_CommandBuffer;
+			VkRenderPassBeginInfo m_RenderPassInfo;
+			VkPipeline m_Pipeline;
+			VkPipelineLayout m_PipelineLayout;
+			VkDescriptorSet m_DescriptorSet;
+		};
+
+		//records drawCount pipeline, descriptor set and draw commands per round, through the loader's trampolines
+		//and through entry points loaded from the device, and reports commands per second for both.
+		//validation says whether the instance was created with the validation layers, which sit in front of both
+		void command_recording(VkInstance instance, VkDevice device, const RecordingTarget& target, bool validation, uint32_t drawCount, uint32_t rounds);
+
+	}
+
+}
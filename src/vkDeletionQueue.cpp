@@ -0,0 +1,186 @@
+#include <vkDeletionQueue.h>
+
+#include <iterator>
+
+//batches are destroyed in this order, users before the objects they were created from
+static const VkObjectType DESTRUCTION_ORDER[] = {
+	VK_OBJECT_TYPE_PIPELINE,
+	VK_OBJECT_TYPE_PIPELINE_LAYOUT,
+	VK_OBJECT_TYPE_DESCRIPTOR_POOL,
+	VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
+	VK_OBJECT_TYPE_SAMPLER,
+	VK_OBJECT_TYPE_SHADER_MODULE,
+	VK_OBJECT_TYPE_PIPELINE_CACHE,
+	VK_OBJECT_TYPE_FRAMEBUFFER,
+	VK_OBJECT_TYPE_RENDER_PASS,
+	VK_OBJECT_TYPE_IMAGE_VIEW,
+	VK_OBJECT_TYPE_IMAGE,
+	VK_OBJECT_TYPE_BUFFER,
+	VK_OBJECT_TYPE_SWAPCHAIN_KHR,
+	VK_OBJECT_TYPE_QUERY_POOL,
+	VK_OBJECT_TYPE_COMMAND_POOL,
+	VK_OBJECT_TYPE_FENCE,
+	VK_OBJECT_TYPE_SEMAPHORE,
+};
+
+constexpr size_t DESTRUCTION_ORDER_COUNT = sizeof(DESTRUCTION_ORDER) / sizeof(DESTRUCTION_ORDER[0]);
+
+template<typename T>
+static T to_handle(uint64_t handle)
+{
+	return (T)handle;
+}
+
+//one switch per batch, the loops themselves are straight calls into the driver
+static void destroy_batch(VkObjectType type, const vkEngine::DeletionRecord* records, size_t count)
+{
+	switch (type)
+	{
+#define DESTROY_BATCH(objectType, HandleType, destroyFn)                                           \
+	case objectType:                                                                               \
+		for (size_t i = 0; i < count; i++)                                                         \
+			destroyFn((VkDevice)records[i].m_Owner, to_handle<HandleType>(records[i].m_Handle), nullptr); \
+		break;
+
+	DESTROY_BATCH(VK_OBJECT_TYPE_PIPELINE, VkPipeline, vkDestroyPipeline)
+	DESTROY_BATCH(VK_OBJECT_TYPE_PIPELINE_LAYOUT, VkPipelineLayout, vkDestroyPipelineLayout)
+	DESTROY_BATCH(VK_OBJECT_TYPE_DESCRIPTOR_POOL, VkDescriptorPool, vkDestroyDescriptorPool)
+	DESTROY_BATCH(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, VkDescriptorSetLayout, vkDestroyDescriptorSetLayout)
+	DESTROY_BATCH(VK_OBJECT_TYPE_SAMPLER, VkSampler, vkDestroySampler)
+	DESTROY_BATCH(VK_OBJECT_TYPE_SHADER_MODULE, VkShaderModule, vkDestroyShaderModule)
+	DESTROY_BATCH(VK_OBJECT_TYPE_PIPELINE_CACHE, VkPipelineCache, vkDestroyPipelineCache)
+	DESTROY_BATCH(VK_OBJECT_TYPE_FRAMEBUFFER, VkFramebuffer, vkDestroyFramebuffer)
+	DESTROY_BATCH(VK_OBJECT_TYPE_RENDER_PASS, VkRenderPass, vkDestroyRenderPass)
+	DESTROY_BATCH(VK_OBJECT_TYPE_IMAGE_VIEW, VkImageView, vkDestroyImageView)
+	DESTROY_BATCH(VK_OBJECT_TYPE_SWAPCHAIN_KHR, VkSwapchainKHR, vkDestroySwapchainKHR)
+	DESTROY_BATCH(VK_OBJECT_TYPE_QUERY_POOL, VkQueryPool, vkDestroyQueryPool)
+	DESTROY_BATCH(VK_OBJECT_TYPE_COMMAND_POOL, VkCommandPool, vkDestroyCommandPool)
+	DESTROY_BATCH(VK_OBJECT_TYPE_FENCE, VkFence, vkDestroyFence)
+	DESTROY_BATCH(VK_OBJECT_TYPE_SEMAPHORE, VkSemaphore, vkDestroySemaphore)
+
+#undef DESTROY_BATCH
+
+	case VK_OBJECT_TYPE_IMAGE:
+		for (size_t i = 0; i < count; i++)
+			vmaDestroyImage((VmaAllocator)records[i].m_Owner, to_handle<VkImage>(records[i].m_Handle), (VmaAllocation)records[i].m_Allocation);
+		break;
+	case VK_OBJECT_TYPE_BUFFER:
+		for (size_t i = 0; i < count; i++)
+			vmaDestroyBuffer((VmaAllocator)records[i].m_Owner, to_handle<VkBuffer>(records[i].m_Handle), (VmaAllocation)records[i].m_Allocation);
+		break;
+	default:
+		break;
+	}
+}
+
+void vkEngine::DeletionQueue::append(DeletionQueue&& other)
+{
+	//closure records index m_Functions, shift them past our own closures
+	size_t functionOffset = m_Functions.size();
+	for (DeletionRecord& record : other.m_Records)
+	{
+		if (record.m_Type == VK_OBJECT_TYPE_UNKNOWN)
+			record.m_Handle += functionOffset;
+		m_Records.push_back(record);
+	}
+	for (std::function<void()>& function : other.m_Functions)
+		m_Functions.push_back(std::move(function));
+
+	other.m_Records.clear();
+	other.m_Functions.clear();
+}
+
+void vkEngine::DeletionQueue::flush()
+{
+	// reverse iterate the deletion queue, every closure splits the typed records into separately batched segments
+	size_t end = m_Records.size();
+	while (end > 0)
+	{
+		size_t begin = end;
+		while (begin > 0 && m_Records[begin - 1].m_Type != VK_OBJECT_TYPE_UNKNOWN)
+			begin--;
+
+		destroy_segment(begin, end);
+
+		if (begin > 0)
+		{
+			m_Functions[m_Records[begin - 1].m_Handle](); //call the function
+			begin--;
+		}
+
+		end = begin;
+	}
+
+	m_Records.clear();
+	m_Functions.clear();
+}
+
+void vkEngine::DeletionQueue::destroy_segment(size_t begin, size_t end)
+{
+	if (begin == end)
+		return;
+
+	//counting sort by destruction rank, walking backwards keeps the reverse registration order inside a type
+	size_t counts[DESTRUCTION_ORDER_COUNT + 1] = {};
+	auto rank_of = [](VkObjectType type) {
+		for (size_t r = 0; r < DESTRUCTION_ORDER_COUNT; r++)
+			if (DESTRUCTION_ORDER[r] == type)
+				return r;
+		return DESTRUCTION_ORDER_COUNT;
+	};
+
+	for (size_t i = begin; i < end; i++)
+		counts[rank_of(m_Records[i].m_Type) + 1]++;
+	for (size_t r = 1; r <= DESTRUCTION_ORDER_COUNT; r++)
+		counts[r] += counts[r - 1];
+
+	m_Scratch.resize(end - begin);
+	for (size_t i = end; i > begin; i--)
+	{
+		const DeletionRecord& record = m_Records[i - 1];
+		m_Scratch[counts[rank_of(record.m_Type)]++] = record;
+	}
+
+	size_t runStart = 0;
+	while (runStart < m_Scratch.size())
+	{
+		size_t runEnd = runStart + 1;
+		while (runEnd < m_Scratch.size() && m_Scratch[runEnd].m_Type == m_Scratch[runStart].m_Type)
+			runEnd++;
+
+		destroy_batch(m_Scratch[runStart].m_Type, &m_Scratch[runStart], runEnd - runStart);
+		runStart = runEnd;
+	}
+
+	m_Scratch.clear();
+}
+
+void vkEngine::DeferredDeletionQueue::collect(uint64_t completedValue)
+{
+	while (!m_Buckets.empty() && m_Buckets.front().m_RetireValue <= completedValue)
+	{
+		m_Buckets.front().m_Queue.flush();
+		m_FreeQueues.push_back(std::move(m_Buckets.front().m_Queue));
+		m_Buckets.pop_front();
+	}
+}
+
+vkEngine::DeletionQueue& vkEngine::DeferredDeletionQueue::queue_for(uint64_t retireValue)
+{
+	//values almost always arrive in order, so this usually lands in the newest bucket
+	auto it = m_Buckets.end();
+	while (it != m_Buckets.begin() && std::prev(it)->m_RetireValue > retireValue)
+		--it;
+
+	if (it != m_Buckets.begin() && std::prev(it)->m_RetireValue == retireValue)
+		return std::prev(it)->m_Queue;
+
+	Bucket bucket{ retireValue, {} };
+	if (!m_FreeQueues.empty())
+	{
+		bucket.m_Queue = std::move(m_FreeQueues.back());
+		m_FreeQueues.pop_back();
+	}
+
+	return m_Buckets.insert(it, std::move(bucket))->m_Queue;
+}
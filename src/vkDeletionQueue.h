@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vkTypes.h>
+#include <vector>
+#include <deque>
+#include <functional>
+
+namespace vkEngine {
+
+	//maps a Vulkan handle type to the object type recorded for it in a DeletionQueue
+	template<typename T> struct ObjectTypeOf;
+	template<> struct ObjectTypeOf<VkSemaphore> { static constexpr VkObjectType value = VK_OBJECT_TYPE_SEMAPHORE; };
+	template<> struct ObjectTypeOf<VkFence> { static constexpr VkObjectType value = VK_OBJECT_TYPE_FENCE; };
+	template<> struct ObjectTypeOf<VkQueryPool> { static constexpr VkObjectType value = VK_OBJECT_TYPE_QUERY_POOL; };
+	template<> struct ObjectTypeOf<VkImageView> { static constexpr VkObjectType value = VK_OBJECT_TYPE_IMAGE_VIEW; };
+	template<> struct ObjectTypeOf<VkShaderModule> { static constexpr VkObjectType value = VK_OBJECT_TYPE_SHADER_MODULE; };
+	template<> struct ObjectTypeOf<VkPipelineCache> { static constexpr VkObjectType value = VK_OBJECT_TYPE_PIPELINE_CACHE; };
+	template<> struct ObjectTypeOf<VkPipelineLayout> { static constexpr VkObjectType value = VK_OBJECT_TYPE_PIPELINE_LAYOUT; };
+	template<> struct ObjectTypeOf<VkRenderPass> { static constexpr VkObjectType value = VK_OBJECT_TYPE_RENDER_PASS; };
+	template<> struct ObjectTypeOf<VkPipeline> { static constexpr VkObjectType value = VK_OBJECT_TYPE_PIPELINE; };
+	template<> struct ObjectTypeOf<VkDescriptorSetLayout> { static constexpr VkObjectType value = VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT; };
+	template<> struct ObjectTypeOf<VkSampler> { static constexpr VkObjectType value = VK_OBJECT_TYPE_SAMPLER; };
+	template<> struct ObjectTypeOf<VkDescriptorPool> { static constexpr VkObjectType value = VK_OBJECT_TYPE_DESCRIPTOR_POOL; };
+	template<> struct ObjectTypeOf<VkFramebuffer> { static constexpr VkObjectType value = VK_OBJECT_TYPE_FRAMEBUFFER; };
+	template<> struct ObjectTypeOf<VkCommandPool> { static constexpr VkObjectType value = VK_OBJECT_TYPE_COMMAND_POOL; };
+	template<> struct ObjectTypeOf<VkSwapchainKHR> { static constexpr VkObjectType value = VK_OBJECT_TYPE_SWAPCHAIN_KHR; };
+
+	//one object waiting for destruction. the owner is the VkDevice, or the VmaAllocator for VMA backed images and buffers
+	struct DeletionRecord
+	{
+		VkObjectType m_Type;
+		uint64_t m_Handle;
+		void* m_Owner;
+		void* m_Allocation;
+	};
+
+	//destroys objects in reverse order of registration. typed records live in contiguous storage and
+	//are destroyed in batches per object type, closures remain available for anything else
+	class DeletionQueue
+	{
+	public:
+		template<typename T>
+		void push(VkDevice device, T handle)
+		{
+			m_Records.push_back({ ObjectTypeOf<T>::value, (uint64_t)handle, (void*)device, nullptr });
+		}
+
+		void push_image(VmaAllocator allocator, VkImage image, VmaAllocation allocation)
+		{
+			m_Records.push_back({ VK_OBJECT_TYPE_IMAGE, (uint64_t)image, (void*)allocator, (void*)allocation });
+		}
+
+		void push_buffer(VmaAllocator allocator, VkBuffer buffer, VmaAllocation allocation)
+		{
+			m_Records.push_back({ VK_OBJECT_TYPE_BUFFER, (uint64_t)buffer, (void*)allocator, (void*)allocation });
+		}
+
+		//fallback for cleanup that is not a plain destroy call, it keeps its place in the destruction order
+		void push_function(std::function<void()>&& function)
+		{
+			m_Records.push_back({ VK_OBJECT_TYPE_UNKNOWN, (uint64_t)m_Functions.size(), nullptr, nullptr });
+			m_Functions.push_back(std::move(function));
+		}
+
+		//moves the other queue's entries behind ours, as if they had been pushed here after everything else
+		void append(DeletionQueue&& other);
+
+		void flush();
+
+		bool empty() const { return m_Records.empty(); }
+		size_t size() const { return m_Records.size(); }
+
+	private:
+		//destroys the typed records between two closures, grouped by type in an order that respects dependencies
+		void destroy_segment(size_t begin, size_t end);
+
+		std::vector<DeletionRecord> m_Records;
+		std::vector<std::function<void()>> m_Functions;
+		//reused between flushes so sorting a segment does not allocate once warmed up
+		std::vector<DeletionRecord> m_Scratch;
+	};
+
+	//deletion queue for objects the GPU may still be using. every entry is tagged with the
+	//timeline value of the last submission that can reference it and runs once the GPU passed that value
+	class DeferredDeletionQueue
+	{
+	public:
+		template<typename T>
+		void push(uint64_t retireValue, VkDevice device, T handle)
+		{
+			queue_for(retireValue).push(device, handle);
+		}
+
+		void push_function(uint64_t retireValue, std::function<void()>&& function)
+		{
+			queue_for(retireValue).push_function(std::move(function));
+		}
+
+		//runs every entry whose value the GPU has reached, oldest first
+		void collect(uint64_t completedValue);
+
+		//runs everything regardless of GPU progress, only valid once the device is idle
+		void flush()
+		{
+			collect(UINT64_MAX);
+		}
+
+		bool empty() const { return m_Buckets.empty(); }
+
+	private:
+		DeletionQueue& queue_for(uint64_t retireValue);
+
+		struct Bucket
+		{
+			uint64_t m_RetireValue;
+			DeletionQueue m_Queue;
+		};
+
+		std::deque<Bucket> m_Buckets;
+		//flushed queues keep their capacity and are handed to the next bucket
+		std::vector<DeletionQueue> m_FreeQueues;
+	};
+
+}
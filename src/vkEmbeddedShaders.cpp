@@ -0,0 +1,21 @@
+#include <vkEmbeddedShaders.h>
+
+#include <cstring>
+
+const vkEngine::EmbeddedShader* vkEngine::find_embedded_shader(const char* path)
+{
+	//the same file name may be asked for through any relative path
+	const char* fileName = path;
+	for (const char* c = path; *c; c++)
+	{
+		if (*c == '/' || *c == '\\')
+			fileName = c + 1;
+	}
+
+	for (const EmbeddedShader* shader = g_EmbeddedShaders; shader->m_Name; shader++)
+	{
+		if (strcmp(shader->m_Name, fileName) == 0)
+			return shader;
+	}
+	return nullptr;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vkEngine {
+
+	//SPIR-V compiled into the executable at build time
+	struct EmbeddedShader
+	{
+		//file name of the .spv it was built from, e.g. "triangleShader.vert.spv"
+		const char* m_Name;
+		const uint32_t* m_Code;
+		//in bytes
+		size_t m_Size;
+	};
+
+	//generated by cmake/EmbedSpirv.cmake, terminated by an entry with a null name
+	extern const EmbeddedShader g_EmbeddedShaders[];
+
+	//finds the embedded shader built from the file path points to, only its file name is compared. nullptr if there is none
+	const EmbeddedShader* find_embedded_shader(const char* path);
+
+}
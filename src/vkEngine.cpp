@@ -6,9 +6,31 @@
 #include <vkTypes.h>
 #include <vkInitializers.h>
 #include <VkBootstrap.h>
+#include <vkBenchmark.h>
+#include <vkProfiler.h>
+#include <vkInitGraph.h>
+
+#define VMA_IMPLEMENTATION
+#include <vk_mem_alloc.h>
 
 #include <iostream>
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+//spir-v init_pipeline builds from. the build embeds them into the executable, files that are not embedded
+//or --shader-files are mapped ahead while the window and the device are created
+static const char* const SHADER_FILES[] = {
+	"../../shaders/triangleShader.vert.spv",
+	"../../shaders/triangleShader.frag.spv",
+};
+
+//glsl sources of the files above, watched for changes with --hot-reload
+static const char* const SHADER_DIRECTORY = "../../shaders";
+static const char* const SHADER_COMPILER = "glslangValidator";
 
 #define VK_CHECK(x)                                                 \
 	do                                                              \
@@ -22,69 +44,271 @@
 	} while (0)
 
 
-void vkEngine::VulkanEngine::init()
+void vkEngine::VulkanEngine::init(const EngineConfig& config)
 {
-	// We initialize SDL and create a window with it. 
-	SDL_Init(SDL_INIT_VIDEO);
+	PROFILE_SCOPE("init");
+	m_FramesInFlight = std::clamp(config.framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT);
+	m_Headless = config.headless;
+	m_Validation = config.validation;
+	m_WindowExtent = config.windowExtent;
+	m_MaxFrames = config.maxFrames;
+	m_PresentMode = config.presentMode;
+	m_FrameLimiter.set_target_frame_time(config.targetFrameTimeMs);
+	m_Threaded = config.threaded;
+	//there is nothing to present without a window
+	m_AsyncPresent = config.asyncPresent && !m_Headless;
+	m_LateLatch = config.lateLatch;
+	m_StatsCsvPath = config.statsCsvPath;
+	m_StatsJsonPath = config.statsJsonPath;
+	m_PipelineCachePath = config.pipelineCachePath;
+	m_ShaderCache.set_use_embedded(config.embeddedShaders);
+
+	m_StatFrame = m_FrameStats.register_timer("cpu.frame");
+	m_StatWait = m_FrameStats.register_timer("cpu.wait");
+	m_StatAcquire = m_FrameStats.register_timer("cpu.acquire");
+	m_StatReset = m_FrameStats.register_timer("cpu.reset");
+	m_StatRecord = m_FrameStats.register_timer("cpu.record");
+	m_StatSubmit = m_FrameStats.register_timer("cpu.submit");
+	m_StatPresent = m_FrameStats.register_timer("cpu.present");
+	m_StatBusy = m_FrameStats.register_timer("cpu.busy");
+
+	//independent steps run on the job system's workers, the order below only matters for destruction,
+	//later steps are cleaned up first
+	m_JobSystem.init();
+	InitGraph graph;
+
+	//SDL wants its window created on the main thread
+	uint32_t windowStep = graph.add_main_thread_step("window", [this](DeletionQueue&) {
+		if (m_Headless)
+			return;
+
+		// We initialize SDL and create a window with it. 
+		SDL_Init(SDL_INIT_VIDEO);
+
+		SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
+
+
+		m_Window = SDL_CreateWindow(
+			"Vulkan Engine",
+			SDL_WINDOWPOS_UNDEFINED,
+			SDL_WINDOWPOS_UNDEFINED,
+			m_WindowExtent.width,
+			m_WindowExtent.height,
+			window_flags
+		);
+	});
 
-	SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_VULKAN);
+	//the spir-v is needed long after this, reading it does not have to wait for the window or the device
+	uint32_t shaderStep = graph.add_step("shader_files", [this](DeletionQueue&) {
+		for (const char* filePath : SHADER_FILES)
+			m_ShaderCache.prefetch(filePath);
+	});
 
-	
-	m_Window = SDL_CreateWindow(
-		"Vulkan Engine",
-		SDL_WINDOWPOS_UNDEFINED,
-		SDL_WINDOWPOS_UNDEFINED,
-		m_WindowExtent.width,
-		m_WindowExtent.height,
-		window_flags
-	);
-	
-	init_vulkan();
-	init_swapchain();
-	init_commands();
-	init_default_renderpass();
-	init_framebuffers();
-	init_sync_structures();
-	init_pipeline();
+	uint32_t vulkanStep = graph.add_main_thread_step("init_vulkan", [this](DeletionQueue& deletionQueue) { init_vulkan(deletionQueue); }, { windowStep });
+
+	//only needs the device and the surface, the render pass and the targets both build on it
+	uint32_t formatStep = graph.add_step("color_format", [this](DeletionQueue&) { select_color_format(); }, { vulkanStep });
+
+	//the swapchain may change m_WindowExtent, every step reading it has to depend on this one
+	uint32_t targetStep = graph.add_step("render_targets", [this](DeletionQueue& deletionQueue) {
+		if (m_Headless)
+			init_offscreen_targets(deletionQueue);
+		else
+			init_swapchain(deletionQueue);
+		//with the present thread the swapchain is only a copy destination, rendering goes to our own targets
+		if (m_AsyncPresent)
+			init_offscreen_targets(deletionQueue);
+	}, { formatStep });
+
+	graph.add_step("init_commands", [this](DeletionQueue& deletionQueue) { init_commands(deletionQueue); }, { vulkanStep });
+
+	graph.add_step("gpu_profiler", [this](DeletionQueue& deletionQueue) {
+		m_GpuProfiler.init(m_Device, m_TargetGPU, m_GraphicsQueueFamily, m_FramesInFlight);
+		m_GpuScopeFrame = m_GpuProfiler.register_scope("gpu.frame", m_FrameStats);
+		m_GpuScopeMainPass = m_GpuProfiler.register_scope("gpu.main_pass", m_FrameStats);
+		deletionQueue.push_function([=]() {
+			m_GpuProfiler.destroy();
+		});
+	}, { vulkanStep });
+
+	uint32_t renderPassStep = graph.add_step("init_default_renderpass", [this](DeletionQueue& deletionQueue) { init_default_renderpass(deletionQueue); }, { formatStep });
+	//sized by m_WindowExtent, which is only final once render_targets is done
+	graph.add_step("init_framebuffers", [this](DeletionQueue& deletionQueue) { init_framebuffers(deletionQueue); }, { renderPassStep, targetStep });
+	graph.add_step("init_sync_structures", [this](DeletionQueue& deletionQueue) { init_sync_structures(deletionQueue); }, { vulkanStep });
+	uint32_t layoutStep = graph.add_step("layout_cache", [this](DeletionQueue& deletionQueue) {
+		m_LayoutCache.init(m_Device);
+		deletionQueue.push_function([=]() {
+			m_LayoutCache.destroy();
+		});
+	}, { vulkanStep });
+	uint32_t descriptorStep = graph.add_step("init_descriptors", [this](DeletionQueue& deletionQueue) { init_descriptors(deletionQueue); }, { layoutStep });
+	uint32_t moduleStep = graph.add_step("shader_cache", [this](DeletionQueue& deletionQueue) {
+		m_ShaderCache.init(m_Device);
+		deletionQueue.push_function([=]() {
+			m_ShaderCache.destroy();
+		});
+	}, { vulkanStep });
+
+	uint32_t cacheStep = graph.add_step("pipeline_cache", [this](DeletionQueue& deletionQueue) {
+		m_PipelineCache.init(m_Device, m_TargetGPU, m_PipelineCachePath);
+		deletionQueue.push(m_Device, m_PipelineCache.get());
+	}, { vulkanStep });
+	graph.add_step("init_pipeline", [this](DeletionQueue& deletionQueue) { init_pipeline(deletionQueue); }, { renderPassStep, descriptorStep, shaderStep, moduleStep, cacheStep });
+
+	//a job system without workers runs every step on this thread, in the order they were added
+	JobSystem serialJobs;
+	graph.run(config.parallelInit ? m_JobSystem : serialJobs);
+	graph.append_deletions(m_MainDeletionQueue);
+	graph.report();
+
+	//run twice to compare, the first run with a given cache file is the cold one
+	std::cout << "  " << m_PipelineRegistry.size() << " unique pipelines, " << m_PipelineRegistry.get_shared_count() << " requests shared an existing one" << std::endl;
+	std::cout << "  " << m_LayoutCache.get_pipeline_layout_count() << " pipeline layouts, " << m_LayoutCache.get_set_layout_count() << " set layouts, " << m_LayoutCache.get_hit_count() << " requests shared an existing one" << std::endl;
+	if (m_PipelineCache.is_warm())
+		std::cout << "  pipelines took " << m_PipelineBuildMs << " ms with a warm cache (" << m_PipelineCache.get_loaded_size() << " bytes from " << m_PipelineCache.get_path() << ")" << std::endl;
+	else
+		std::cout << "  pipelines took " << m_PipelineBuildMs << " ms with a cold cache" << std::endl;
+
+	//the swapchain may have picked a different size than the window asked for
+	m_GameState.m_DrawableExtent = m_WindowExtent;
 
 	//everything went fine
+	if (config.hotReload)
+	{
+		//started last, reloads need the pipelines init_pipeline built
+		if (m_ShaderWatcher.start(SHADER_DIRECTORY, SHADER_COMPILER, [this](const std::string& spirvPath) { reload_shader(spirvPath); }))
+			std::cout << "Watching " << SHADER_DIRECTORY << " for shader changes" << std::endl;
+	}
+
 	m_IsInitialized = true;
 }
 void vkEngine::VulkanEngine::cleanup()
 {
+	PROFILE_SCOPE("cleanup");
 	if (m_IsInitialized) 
 	{
+		//a reload or a variant compile in progress still uses the caches and the device
+		m_ShaderWatcher.stop();
+		m_TrianglePermutations.destroy();
+
+		//make sure the GPU has stopped doing its things, the last value covers every frame that may still be in flight
+		m_GraphicsTimeline.wait(m_GraphicsTimeline.last_submitted_value(), 1000000000);
+		m_PresentTimeline.wait(m_PresentTimeline.last_submitted_value(), 1000000000);
+
+		//pipelines no frame picked up yet go to the registry, which destroys them with the rest
+		swap_reloaded_pipelines();
+
+		m_FrameDeletionQueue.flush();
+		m_PresentDeletionQueue.flush();
 
-		//make sure the GPU has stopped doing its things
-		vkWaitForFences(m_Device, 1, &m_RenderFence, true, 1000000000);
+		//everything compiled this run goes to disk before the cache is destroyed with the rest
+		m_PipelineCache.save();
 
 		m_MainDeletionQueue.flush();
 
 		vkDestroyDevice(m_Device, nullptr);
-		vkDestroySurfaceKHR(m_Instance, m_vkSurface, nullptr);
-		vkb::destroy_debug_utils_messenger(m_Instance, m_DebugMessanger);
+		if (!m_Headless)
+			vkDestroySurfaceKHR(m_Instance, m_vkSurface, nullptr);
+		if (m_DebugMessanger != VK_NULL_HANDLE)
+			vkb::destroy_debug_utils_messenger(m_Instance, m_DebugMessanger);
 		vkDestroyInstance(m_Instance, nullptr);
-		SDL_DestroyWindow(m_Window);
+		if (m_Window)
+			SDL_DestroyWindow(m_Window);
+
+		m_JobSystem.destroy();
 	}
 }
 
-void vkEngine::VulkanEngine::draw()
+void vkEngine::VulkanEngine::draw(const FrameSnapshot& snapshot)
 {
-	VK_CHECK(vkWaitForFences(m_Device, 1, &m_RenderFence, true, 1000000000));
-	VK_CHECK(vkResetFences	(m_Device, 1, &m_RenderFence));
+	PROFILE_SCOPE("draw");
+	FrameData& frame = get_current_frame();
+
+	//each phase is timed from the end of the previous one, so together they cover the whole call
+	m_FrameStats.begin_frame(m_FrameNumber);
+	FrameStats::Clock::time_point frameStart = FrameStats::Clock::now();
+	FrameStats::Clock::time_point phaseStart = frameStart;
+
+	//only wait for the GPU to finish the frame that last used this slot, the other slots can still be executing
+	if (!m_GraphicsTimeline.wait(frame.m_TimelineValue, 1000000000))
+	{
+		std::cout << "Timed out waiting for frame " << m_FrameNumber - m_FramesInFlight << std::endl;
+		abort();
+	}
+
+	//the wait above may have moved the timeline past objects older frames were holding on to
+	m_FrameDeletionQueue.collect(m_GraphicsTimeline.completed_value());
+
+	//frame boundary, nothing recorded from here on uses the pipelines being replaced
+	swap_reloaded_pipelines();
 
+	phaseStart = end_phase(m_StatWait, "draw.wait", phaseStart);
 
-	//request image from the swapchain, one second timeoutk
 	uint32_t swapchainImageIndex ;
-	VK_CHECK(vkAcquireNextImageKHR(m_Device, m_Swapchain, 1000000000, m_PresentSemaphore, nullptr, &swapchainImageIndex));
-		
+	if (m_Headless || m_AsyncPresent)
+	{
+		//the present thread may still be copying out of the target this slot rendered last time.
+		//this is the only place the recording thread blocks on presentation, once the whole frame budget is queued up
+		if (m_AsyncPresent && m_FrameNumber >= m_FramesInFlight)
+		{
+			if (!m_PresentTimeline.wait(m_FrameNumber - m_FramesInFlight + 1, 1000000000))
+			{
+				std::cout << "Timed out waiting for the present of frame " << m_FrameNumber - m_FramesInFlight << std::endl;
+				abort();
+			}
+		}
+
+		//offscreen targets belong to a frame slot, so the timeline wait above already made ours available
+		swapchainImageIndex = m_FrameNumber % m_FramesInFlight;
+	}
+	else
+	{
+		if (snapshot.m_ResizeCount != m_SeenResizeCount)
+		{
+			m_SeenResizeCount = snapshot.m_ResizeCount;
+			m_SwapchainDirty = true;
+		}
+
+		if (m_SwapchainDirty)
+		{
+			recreate_swapchain(snapshot.m_DrawableExtent);
+		}
+
+		//request image from the swapchain, one second timeoutk
+		VkResult acquireResult = vkAcquireNextImageKHR(m_Device, m_Swapchain, 1000000000, frame.m_PresentSemaphore, nullptr, &swapchainImageIndex);
+
+		//nothing has been recorded yet, so the slot can simply be reused by the next attempt
+		if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			recreate_swapchain(snapshot.m_DrawableExtent);
+			return;
+		}
+		//suboptimal still signals the semaphore, so render this frame and rebuild after presenting it
+		if (acquireResult == VK_SUBOPTIMAL_KHR)
+		{
+			m_SwapchainDirty = true;
+		}
+		else
+		{
+			VK_CHECK(acquireResult);
+		}
+	}
+
+	//this frame is going to be submitted now, reserve the value it signals so anything released
+	//while recording is kept alive until the frame finished
+	frame.m_TimelineValue = m_GraphicsTimeline.next_signal_value();
+
+	//with the present thread this is the wait for a free render target
+	phaseStart = end_phase(m_StatAcquire, "draw.acquire", phaseStart);
 
 	//now that we are sure that the commands finished executing, we can safely reset the command buffer to begin recording again.
-	VK_CHECK(vkResetCommandBuffer(m_MainCommandBuffer, 0));
+	VK_CHECK(vkResetCommandBuffer(frame.m_MainCommandBuffer, 0));
+
+	phaseStart = end_phase(m_StatReset, "draw.reset", phaseStart);
 
 
 	//naming it cmd for shorter writing
-	VkCommandBuffer cmd = m_MainCommandBuffer;
+	VkCommandBuffer cmd = frame.m_MainCommandBuffer;
 
 	//begin the command buffer recording. We will use this command buffer exactly once, so we want to let Vulkan know that
 	VkCommandBufferBeginInfo cmdBeginInfo = {};
@@ -96,6 +320,9 @@ void vkEngine::VulkanEngine::draw()
 
 	VK_CHECK(vkBeginCommandBuffer(cmd, &cmdBeginInfo));
 
+	//the timeline wait above means the slot's previous queries are done, so this picks them up without stalling
+	m_GpuProfiler.begin_frame(cmd, m_FrameNumber % m_FramesInFlight, m_FrameNumber, m_FrameStats);
+	m_GpuProfiler.begin_scope(cmd, m_GpuScopeFrame);
 
 	//make a clear-color from frame number. This will flash with a 120*pi frame period.
 	VkClearValue clearValue;
@@ -119,156 +346,818 @@ void vkEngine::VulkanEngine::draw()
 	rpInfo.clearValueCount = 1;
 	rpInfo.pClearValues = &clearValue;
 
+	m_GpuProfiler.begin_scope(cmd, m_GpuScopeMainPass);
 	vkCmdBeginRenderPass(cmd, &rpInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 
-	if(m_ShaderIndex == 0)
-	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_TrianglePipeline);
-	else 
-	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_SpecialTrianglePipeline);
-	
+	//the pipelines leave viewport and scissor dynamic, so a resize never touches them
+	VkViewport viewport = {};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = (float)rpInfo.renderArea.extent.width;
+	viewport.height = (float)rpInfo.renderArea.extent.height;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(cmd, 0, 1, &viewport);
+	vkCmdSetScissor(cmd, 0, 1, &rpInfo.renderArea);
+
+	//a variant shown for the first time starts compiling on a worker, the fallback variant stands in until it is done
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineRegistry.get(m_TrianglePermutations.get(snapshot.m_ShaderIndex)));
+
+	//every variant shares the layout, the uniform slot itself is only filled in right before submit
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_TrianglePipelineLayout, 0, 1, &frame.m_FrameDescriptor, 0, nullptr);
+
 	vkCmdDraw(cmd, 3, 1, 0, 0);
 
 	//finalize the render pass
 	vkCmdEndRenderPass(cmd);
+	m_GpuProfiler.end_scope(cmd, m_GpuScopeMainPass);
+
+	m_GpuProfiler.end_scope(cmd, m_GpuScopeFrame);
 	//finalize the command buffer (we can no longer add commands, but it can now be executed)
 	VK_CHECK(vkEndCommandBuffer(cmd));
 
+	//the GPU reads the uniform slot when it executes the frame, so anything written before the submit still makes it in
+	FrameLimiter::Clock::time_point inputTime = latch_frame_uniforms(frame, snapshot);
+	if (!m_AsyncPresent)
+		m_FrameLimiter.mark_input(inputTime);
+
+	phaseStart = end_phase(m_StatRecord, "draw.record", phaseStart);
+
 
 		//prepare the submission to the queue.
 	//we want to wait on the _presentSemaphore, as that semaphore is signaled when the swapchain is ready
 	//we will signal the _renderSemaphore, to signal that rendering has finished
+	//and the next graphics timeline value, to signal that the frame slot can be reused
 
 	VkSubmitInfo submit = {};
 	submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	submit.pNext = nullptr;
 
-	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-
-	submit.pWaitDstStageMask = &waitStage;
-
-	submit.waitSemaphoreCount = 1;
-	submit.pWaitSemaphores = &m_PresentSemaphore;
-
-	submit.signalSemaphoreCount = 1;
-	submit.pSignalSemaphores = &m_RenderSemaphore;
+	SubmitSync sync;
+	//headless frames have no acquire to wait on and no present to signal, the present thread does both itself
+	if (!m_Headless && !m_AsyncPresent)
+	{
+		sync.wait(frame.m_PresentSemaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		sync.signal(frame.m_RenderSemaphore);
+	}
+	sync.signal(m_GraphicsTimeline.get(), frame.m_TimelineValue);
+	sync.apply(submit);
 
 	submit.commandBufferCount = 1;
 	submit.pCommandBuffers = &cmd;
 
 	//submit command buffer to the queue and execute it.
-	// _renderFence will now block until the graphic commands finish execution
-	VK_CHECK(vkQueueSubmit(m_GraphicsQueue, 1, &submit, m_RenderFence));
+	// the timeline will reach frame.m_TimelineValue once the graphic commands finish execution
+	{
+		std::lock_guard<std::mutex> lock(m_QueueMutex);
+		VK_CHECK(vkQueueSubmit(m_GraphicsQueue, 1, &submit, VK_NULL_HANDLE));
+	}
 
+	phaseStart = end_phase(m_StatSubmit, "draw.submit", phaseStart);
 
-	// this will put the image we just rendered into the visible window.
-	// we want to wait on the _renderSemaphore for that,
-	// as it's necessary that drawing commands have finished before the image is displayed to the user
-	VkPresentInfoKHR presentInfo = {};
-	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-	presentInfo.pNext = nullptr;
+	//with the present thread this only hands the frame over
+	if (m_AsyncPresent)
+	{
+		PresentRequest request;
+		request.m_Slot = m_FrameNumber % m_FramesInFlight;
+		request.m_TimelineValue = frame.m_TimelineValue;
+		request.m_DrawableExtent = snapshot.m_DrawableExtent;
+		request.m_ResizeCount = snapshot.m_ResizeCount;
+		request.m_InputTime = inputTime;
 
-	presentInfo.pSwapchains = &m_Swapchain;
+		{
+			std::lock_guard<std::mutex> lock(m_PresentMutex);
+			m_PresentRequests.push_back(request);
+		}
+		m_PresentCondition.notify_one();
+	}
+	//headless frames have nothing to present, the finished image simply stays in its offscreen target
+	else if (m_Headless)
+	{
+		m_FrameLimiter.mark_presented();
+	}
+	else
+	{
+		// this will put the image we just rendered into the visible window.
+		// we want to wait on the _renderSemaphore for that,
+		// as it's necessary that drawing commands have finished before the image is displayed to the user
+		VkPresentInfoKHR presentInfo = {};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.pNext = nullptr;
 
+		presentInfo.pSwapchains = &m_Swapchain;
 
-	presentInfo.swapchainCount = 1;
 
-	presentInfo.pWaitSemaphores = &m_RenderSemaphore;
-	presentInfo.waitSemaphoreCount = 1;
+		presentInfo.swapchainCount = 1;
 
-	presentInfo.pImageIndices = &swapchainImageIndex;
+		presentInfo.pWaitSemaphores = &frame.m_RenderSemaphore;
+		presentInfo.waitSemaphoreCount = 1;
 
-	VK_CHECK(vkQueuePresentKHR(m_GraphicsQueue, &presentInfo));
+		presentInfo.pImageIndices = &swapchainImageIndex;
 
-	//increase the number of frames drawn
-	m_FrameNumber++;
+		VkResult presentResult;
+		{
+			std::lock_guard<std::mutex> lock(m_QueueMutex);
+			presentResult = vkQueuePresentKHR(m_GraphicsQueue, &presentInfo);
+		}
+		m_FrameLimiter.mark_presented();
 
-	if (m_FrameNumber == 120)
-		m_FrameNumber = 0;
+		if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR)
+		{
+			m_SwapchainDirty = true;
+		}
+		else
+		{
+			VK_CHECK(presentResult);
+		}
+	}
+
+	end_phase(m_StatPresent, "draw.present", phaseStart);
+	m_FrameStats.lap(m_StatFrame, frameStart);
+	m_FrameStats.record(m_StatBusy, m_FrameStats.get_current(m_StatFrame) - m_FrameStats.get_current(m_StatWait) - m_FrameStats.get_current(m_StatAcquire));
+	m_FrameStats.end_frame();
 
+	//increase the number of frames drawn, this also moves us to the next frame slot
+	m_FrameNumber++;
+}
+vkEngine::FrameStats::Clock::time_point vkEngine::VulkanEngine::end_phase(uint32_t timer, const char* traceName, FrameStats::Clock::time_point start)
+{
+	FrameStats::Clock::time_point now = m_FrameStats.lap(timer, start);
+	PROFILE_EVENT(traceName, start, now);
+	return now;
 }
 void vkEngine::VulkanEngine::run()
 {
-	SDL_Event e;
 	bool bQuit = false;
 
-	//main loop
-	while (!bQuit)
+	auto start = std::chrono::high_resolution_clock::now();
+
+	if (m_AsyncPresent)
+		m_PresentThread = std::thread(&VulkanEngine::present_loop, this);
+
+	if (m_Threaded)
+	{
+		//the render thread must never see an empty snapshot
+		m_GameState.m_InputTime = FrameLimiter::Clock::now();
+		m_Snapshots.write_slot() = m_GameState;
+		m_Snapshots.publish();
+
+		m_RenderThread = std::thread(&VulkanEngine::render_loop, this);
+
+		//the main thread only deals with SDL and game state, rendering speed no longer affects how fast input is handled
+		while (!bQuit && !m_QuitRequested.load(std::memory_order_acquire))
+		{
+			if (m_Headless)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			else
+			{
+				//wake up as soon as input arrives, but publish at least once a millisecond
+				SDL_WaitEventTimeout(nullptr, 1);
+				bQuit = process_events(m_GameState);
+			}
+
+			m_GameState.m_InputTime = FrameLimiter::Clock::now();
+			m_Snapshots.write_slot() = m_GameState;
+			m_Snapshots.publish();
+		}
+
+		m_QuitRequested.store(true, std::memory_order_release);
+		m_RenderThread.join();
+	}
+	else
 	{
-		//Handle events on queue
-		while (SDL_PollEvent(&e) != 0)
+		//main loop
+		while (!bQuit)
 		{
+			//pace before polling, so the input we sample is as recent as possible when the frame goes out
+			m_FrameLimiter.wait_for_next_frame();
+
+			bQuit = process_events(m_GameState);
+			m_GameState.m_InputTime = FrameLimiter::Clock::now();
+			m_FrameLimiter.mark_input(m_GameState.m_InputTime);
 
-			if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_SPACE) 
+			//a minimized window has a zero sized surface, so there is nothing to draw into
+			if (m_GameState.m_Minimized)
 			{
-				const uint32_t MaxPipelineNum = 2;
-				m_ShaderIndex++;
-				if (m_ShaderIndex == MaxPipelineNum) m_ShaderIndex = 0;
+				SDL_Delay(10);
+				continue;
 			}
-				
 
-			//close the window when user alt-f4s or clicks the X button			
-			if (e.type == SDL_QUIT) bQuit = true;
+			draw(m_GameState);
+
+			if (m_MaxFrames != 0 && m_FrameNumber >= m_MaxFrames) bQuit = true;
 		}
-	
+	}
+
+	//the frames still queued for presentation are part of the run
+	if (m_AsyncPresent)
+		stop_present_thread();
+
+	auto end = std::chrono::high_resolution_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+	std::cout << "Rendered " << m_FrameNumber << " frames in " << seconds << " s (" << m_FrameNumber / seconds << " FPS)" << std::endl;
+	m_FrameLimiter.report();
+
+	m_FrameStats.report();
+	if (m_GpuProfiler.is_enabled())
+	{
+		//whichever side needs longer per frame is the one the other ends up waiting for
+		double gpuMs = m_FrameStats.get_percentiles(m_GpuProfiler.get_timer(m_GpuScopeFrame)).m_P50;
+		double cpuMs = m_FrameStats.get_percentiles(m_StatBusy).m_P50;
+		std::cout << (gpuMs > cpuMs ? "GPU bound" : "CPU bound") << ": median GPU frame " << gpuMs << " ms, median CPU work " << cpuMs << " ms" << std::endl;
+	}
+	if (!m_StatsCsvPath.empty())
+		m_FrameStats.write_csv(m_StatsCsvPath);
+	if (!m_StatsJsonPath.empty())
+		m_FrameStats.write_json(m_StatsJsonPath);
+
+	if (m_LatchSamples != 0)
+	{
+		double staleMs = m_StaleInputAgeSumMs / m_LatchSamples;
+		double latchedMs = m_LatchedInputAgeSumMs / m_LatchSamples;
+		std::cout << "Late latch: input was " << latchedMs << " ms old at submit instead of " << staleMs
+			<< " ms (saved avg " << staleMs - latchedMs << " ms, max " << m_LatchSavedMaxMs << " ms)" << std::endl;
+	}
+}
+bool vkEngine::VulkanEngine::process_events(FrameSnapshot& state)
+{
+	SDL_Event e;
+	bool bQuit = false;
+
+	//Handle events on queue, there is no event source without a window
+	while (!m_Headless && SDL_PollEvent(&e) != 0)
+	{
+
+		if (e.type == SDL_WINDOWEVENT)
+		{
+			switch (e.window.event)
+			{
+			case SDL_WINDOWEVENT_SIZE_CHANGED:
+			case SDL_WINDOWEVENT_RESTORED:
+			{
+				//the drawable size can differ from the window size on high dpi displays
+				int width = 0, height = 0;
+				SDL_Vulkan_GetDrawableSize(m_Window, &width, &height);
+				state.m_DrawableExtent = { (uint32_t)width, (uint32_t)height };
+				state.m_ResizeCount++;
+				if (e.window.event == SDL_WINDOWEVENT_RESTORED)
+					state.m_Minimized = false;
+				break;
+			}
+			case SDL_WINDOWEVENT_MINIMIZED:
+				state.m_Minimized = true;
+				break;
+			}
+		}
+
+		if (e.type == SDL_MOUSEMOTION)
+		{
+			int width = 0, height = 0;
+			SDL_GetWindowSize(m_Window, &width, &height);
+			if (width > 0 && height > 0)
+				state.m_Pointer = { e.motion.x * 2.f / width - 1.f, e.motion.y * 2.f / height - 1.f };
+		}
+
+		if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_SPACE) 
+		{
+			state.m_ShaderIndex++;
+			if (state.m_ShaderIndex == m_TrianglePermutations.variant_count()) state.m_ShaderIndex = 0;
+		}
+			
+
+		//close the window when user alt-f4s or clicks the X button			
+		if (e.type == SDL_QUIT) bQuit = true;
+	}
+
+	return bQuit;
+}
+void vkEngine::VulkanEngine::render_loop()
+{
+	PROFILE_THREAD_NAME("render");
+
+	while (!m_QuitRequested.load(std::memory_order_acquire))
+	{
+		m_FrameLimiter.wait_for_next_frame();
+
+		//pick up the newest snapshot, or keep drawing the last one if the main thread has not published since.
+		//copied, the late latch in draw() may advance the triple buffer while the frame is recorded
+		m_Snapshots.update();
+		FrameSnapshot snapshot = m_Snapshots.read_slot();
+
+		if (snapshot.m_Minimized)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			continue;
+		}
+
+		m_FrameLimiter.mark_input(snapshot.m_InputTime);
+		draw(snapshot);
+
+		if (m_MaxFrames != 0 && m_FrameNumber >= m_MaxFrames)
+			m_QuitRequested.store(true, std::memory_order_release);
+	}
+}
+vkEngine::LatchedInput vkEngine::VulkanEngine::sample_latest_input()
+{
+	LatchedInput input;
+	input.m_SampleTime = FrameLimiter::Clock::now();
+
+	if (m_Threaded)
+	{
+		//whatever the main thread published last, the render thread already holds a copy of the older snapshot
+		m_Snapshots.update();
+		input.m_Pointer = m_Snapshots.read_slot().m_Pointer;
+		input.m_SampleTime = m_Snapshots.read_slot().m_InputTime;
+	}
+	else if (!m_Headless)
+	{
+		//refreshes SDL's input state, the events stay queued for the next process_events
+		SDL_PumpEvents();
+
+		int x = 0, y = 0, width = 0, height = 0;
+		SDL_GetMouseState(&x, &y);
+		SDL_GetWindowSize(m_Window, &width, &height);
+		input.m_Pointer = m_GameState.m_Pointer;
+		if (width > 0 && height > 0)
+			input.m_Pointer = { x * 2.f / width - 1.f, y * 2.f / height - 1.f };
+	}
+	else
+	{
+		//no input device, a pointer circling over time still shows how fresh the latched data is
+		double seconds = std::chrono::duration<double>(input.m_SampleTime.time_since_epoch()).count();
+		input.m_Pointer = { 0.5f * (float)cos(seconds), 0.5f * (float)sin(seconds) };
+	}
+
+	return input;
+}
+vkEngine::FrameLimiter::Clock::time_point vkEngine::VulkanEngine::latch_frame_uniforms(FrameData& frame, const FrameSnapshot& snapshot)
+{
+	LatchedInput input = { snapshot.m_Pointer, snapshot.m_InputTime };
+	if (m_LateLatch)
+		input = sample_latest_input();
+
+	FrameUniforms uniforms;
+	uniforms.m_Transform = glm::translate(glm::mat4(1.f), glm::vec3(input.m_Pointer, 0.f)) * glm::scale(glm::mat4(1.f), glm::vec3(0.5f));
+
+	//the slot is only read by this frame, and the timeline wait in draw() made sure the last frame using it finished
+	memcpy(frame.m_UniformData, &uniforms, sizeof(FrameUniforms));
+	VK_CHECK(vmaFlushAllocation(m_Allocator, frame.m_UniformBuffer.m_Allocation, 0, VK_WHOLE_SIZE));
+
+	if (m_LateLatch)
+	{
+		FrameLimiter::Clock::time_point now = FrameLimiter::Clock::now();
+		double staleMs = std::chrono::duration<double, std::milli>(now - snapshot.m_InputTime).count();
+		double latchedMs = std::chrono::duration<double, std::milli>(now - input.m_SampleTime).count();
+
+		m_StaleInputAgeSumMs += staleMs;
+		m_LatchedInputAgeSumMs += latchedMs;
+		m_LatchSavedMaxMs = std::max(m_LatchSavedMaxMs, staleMs - latchedMs);
+		m_LatchSamples++;
+	}
+
+	return input.m_SampleTime;
+}
+void vkEngine::VulkanEngine::present_loop()
+{
+	PROFILE_THREAD_NAME("present");
+
+	while (true)
+	{
+		PresentRequest request;
+		{
+			std::unique_lock<std::mutex> lock(m_PresentMutex);
+			m_PresentCondition.wait(lock, [this]() { return !m_PresentRequests.empty() || m_PresentStop; });
+
+			if (m_PresentRequests.empty())
+				return;
+
+			request = m_PresentRequests.front();
+			m_PresentRequests.pop_front();
+		}
+
+		present_frame(request);
+	}
+}
+void vkEngine::VulkanEngine::present_frame(const PresentRequest& request)
+{
+	PROFILE_SCOPE("present_frame");
+	FrameData& frame = m_Frames[request.m_Slot];
+
+	m_PresentDeletionQueue.collect(m_PresentTimeline.completed_value());
+
+	if (request.m_ResizeCount != m_SeenResizeCount)
+	{
+		m_SeenResizeCount = request.m_ResizeCount;
+		m_SwapchainDirty = true;
+	}
+
+	if (m_SwapchainDirty)
+	{
+		recreate_swapchain(request.m_DrawableExtent);
+	}
+
+	//still dirty means the window has no size, the frame is dropped but its copy value is signaled regardless
+	bool canPresent = !m_SwapchainDirty;
+	uint32_t imageIndex = 0;
+
+	if (canPresent)
+	{
+		//the slot's semaphores are free, the recording thread waited for this slot's previous copy before reusing it
+		VkResult acquireResult = vkAcquireNextImageKHR(m_Device, m_Swapchain, 1000000000, frame.m_PresentSemaphore, nullptr, &imageIndex);
+
+		//drop this frame and rebuild before the next one
+		if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			m_SwapchainDirty = true;
+			canPresent = false;
+		}
+		else if (acquireResult == VK_SUBOPTIMAL_KHR)
+		{
+			m_SwapchainDirty = true;
+		}
+		else
+		{
+			VK_CHECK(acquireResult);
+		}
+	}
+
+	VkCommandBuffer cmd = frame.m_PresentCommandBuffer;
+	VK_CHECK(vkResetCommandBuffer(cmd, 0));
+
+	VkCommandBufferBeginInfo cmdBeginInfo = {};
+	cmdBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	cmdBeginInfo.pNext = nullptr;
+
+	cmdBeginInfo.pInheritanceInfo = nullptr;
+	cmdBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	VK_CHECK(vkBeginCommandBuffer(cmd, &cmdBeginInfo));
+
+	if (canPresent)
+	{
+		VkImage presentImage = m_PresentImages[imageIndex];
+
+		//the transition waits for the acquire semaphore, which is waited on at the transfer stage
+		VkImageMemoryBarrier toTransfer = vkInit::image_memory_barrier(presentImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+		//the render targets keep the size they were created with, the blit scales them to the window
+		VkImageBlit blit = {};
+		blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		blit.srcOffsets[1] = { (int32_t)m_WindowExtent.width, (int32_t)m_WindowExtent.height, 1 };
+		blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		blit.dstOffsets[1] = { (int32_t)m_PresentExtent.width, (int32_t)m_PresentExtent.height, 1 };
+
+		vkCmdBlitImage(cmd, m_SwapchainImages[request.m_Slot], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			presentImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+		VkImageMemoryBarrier toPresent = vkInit::image_memory_barrier(presentImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_ACCESS_TRANSFER_WRITE_BIT, 0);
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &toPresent);
+	}
 
-		draw();
+	VK_CHECK(vkEndCommandBuffer(cmd));
+
+	VkSubmitInfo submit = {};
+	submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit.pNext = nullptr;
+
+	//the render target has to be finished before the blit reads it
+	SubmitSync sync;
+	sync.wait(m_GraphicsTimeline.get(), VK_PIPELINE_STAGE_TRANSFER_BIT, request.m_TimelineValue);
+	if (canPresent)
+	{
+		sync.wait(frame.m_PresentSemaphore, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		sync.signal(frame.m_RenderSemaphore);
 	}
+	//requests arrive in frame order and each one submits exactly once, so this is the frame number + 1
+	sync.signal(m_PresentTimeline.get(), m_PresentTimeline.next_signal_value());
+	sync.apply(submit);
+
+	submit.commandBufferCount = 1;
+	submit.pCommandBuffers = &cmd;
+
+	VkPresentInfoKHR presentInfo = {};
+	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	presentInfo.pNext = nullptr;
+
+	presentInfo.pSwapchains = &m_Swapchain;
+	presentInfo.swapchainCount = 1;
+
+	presentInfo.pWaitSemaphores = &frame.m_RenderSemaphore;
+	presentInfo.waitSemaphoreCount = 1;
+
+	presentInfo.pImageIndices = &imageIndex;
+
+	VkResult presentResult = VK_SUCCESS;
+	{
+		std::lock_guard<std::mutex> lock(m_QueueMutex);
+		VK_CHECK(vkQueueSubmit(m_GraphicsQueue, 1, &submit, VK_NULL_HANDLE));
+		if (canPresent)
+			presentResult = vkQueuePresentKHR(m_GraphicsQueue, &presentInfo);
+	}
+
+	if (!canPresent)
+		return;
+
+	m_FrameLimiter.mark_presented(request.m_InputTime);
+
+	if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR)
+	{
+		m_SwapchainDirty = true;
+	}
+	else
+	{
+		VK_CHECK(presentResult);
+	}
+}
+void vkEngine::VulkanEngine::stop_present_thread()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_PresentMutex);
+		m_PresentStop = true;
+	}
+	m_PresentCondition.notify_one();
+	m_PresentThread.join();
+}
+bool vkEngine::VulkanEngine::run_benchmark(const char* name)
+{
+	if (strcmp(name, "deletion-queue") == 0)
+		bench::deletion_queue(m_Device, 1000000);
+	else if (strcmp(name, "command-recording") == 0)
+	{
+		//records the main pass the way draw() does, without ever submitting it
+		VkClearValue clearValue;
+		clearValue.color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+
+		bench::RecordingTarget target;
+		target.m_CommandBuffer = m_Frames[0].m_MainCommandBuffer;
+		target.m_RenderPassInfo = {};
+		target.m_RenderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		target.m_RenderPassInfo.renderPass = m_RenderPass;
+		target.m_RenderPassInfo.renderArea.extent = m_WindowExtent;
+		target.m_RenderPassInfo.framebuffer = m_Framebuffers[0];
+		target.m_RenderPassInfo.clearValueCount = 1;
+		target.m_RenderPassInfo.pClearValues = &clearValue;
+		target.m_Pipeline = m_PipelineRegistry.get(m_TrianglePermutations.get_fallback());
+		target.m_PipelineLayout = m_TrianglePipelineLayout;
+		target.m_DescriptorSet = m_Frames[0].m_FrameDescriptor;
+
+		bench::command_recording(m_Instance, m_Device, target, m_Validation, 10000, 200);
+	}
+	else
+		return false;
+	return true;
 }
-void vkEngine::VulkanEngine::init_commands()
+void vkEngine::VulkanEngine::init_commands(DeletionQueue& deletionQueue)
 {
+	PROFILE_SCOPE("init_commands");
 	//create a command pool for commands submitted to the graphics queue.
 	//we also want the pool to allow for resetting of individual command buffers
 	VkCommandPoolCreateInfo commandPoolInfo = vkInit::command_pool_create_info(m_GraphicsQueueFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 
-	VK_CHECK(vkCreateCommandPool(m_Device, &commandPoolInfo, nullptr, &m_CommandPool));
+	//every frame slot gets its own pool, so recording a frame never touches a pool the GPU may still be reading from
+	for (uint32_t i = 0; i < m_FramesInFlight; i++)
+	{
+		VK_CHECK(vkCreateCommandPool(m_Device, &commandPoolInfo, nullptr, &m_Frames[i].m_CommandPool));
 
-	//allocate the default command buffer that we will use for rendering
-	VkCommandBufferAllocateInfo cmdAllocInfo = vkInit::command_buffer_allocate_info(m_CommandPool, 1);
+		//allocate the default command buffer that we will use for rendering
+		VkCommandBufferAllocateInfo cmdAllocInfo = vkInit::command_buffer_allocate_info(m_Frames[i].m_CommandPool, 1);
 
-	VK_CHECK(vkAllocateCommandBuffers(m_Device, &cmdAllocInfo, &m_MainCommandBuffer));
-	
-	
-	m_MainDeletionQueue.push_function([=]() {
-		vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+		VK_CHECK(vkAllocateCommandBuffers(m_Device, &cmdAllocInfo, &m_Frames[i].m_MainCommandBuffer));
+
+
+		deletionQueue.push(m_Device, m_Frames[i].m_CommandPool);
+
+		//the present thread records its copies from a pool of its own, pools are not thread safe
+		if (m_AsyncPresent)
+		{
+			VK_CHECK(vkCreateCommandPool(m_Device, &commandPoolInfo, nullptr, &m_Frames[i].m_PresentCommandPool));
+
+			VkCommandBufferAllocateInfo presentAllocInfo = vkInit::command_buffer_allocate_info(m_Frames[i].m_PresentCommandPool, 1);
+			VK_CHECK(vkAllocateCommandBuffers(m_Device, &presentAllocInfo, &m_Frames[i].m_PresentCommandBuffer));
+
+			deletionQueue.push(m_Device, m_Frames[i].m_PresentCommandPool);
+		}
+	}
+
+}
+void vkEngine::VulkanEngine::init_swapchain(DeletionQueue& deletionQueue)
+{
+	PROFILE_SCOPE("init_swapchain");
+	m_PresentMode = select_present_mode(m_PresentMode);
+
+	create_swapchain(VK_NULL_HANDLE, m_WindowExtent);
+
+	//reads m_Swapchain when the queue is flushed, so it always destroys the current one
+	deletionQueue.push_function([=]() {
+		vkDestroySwapchainKHR(m_Device, m_Swapchain, nullptr);
 	});
 
 }
-void vkEngine::VulkanEngine::init_swapchain()
+void vkEngine::VulkanEngine::create_swapchain(VkSwapchainKHR oldSwapchain, VkExtent2D extent)
 {
+	PROFILE_SCOPE("create_swapchain");
 	vkb::SwapchainBuilder swapchainBuilder{m_TargetGPU,m_Device,m_vkSurface};
 
 	vkb::Swapchain vkbSwapchain = swapchainBuilder
-		.use_default_format_selection()
-		//use vsync present mode
-		.set_desired_present_mode(VK_PRESENT_MODE_FIFO_KHR)
-		.set_desired_extent(m_WindowExtent.width, m_WindowExtent.height)
+		//chosen by select_color_format, the render pass was already built for it
+		.set_desired_format(m_SurfaceFormat)
+		.set_desired_present_mode(m_PresentMode)
+		//FIFO is the only mode every surface has to support
+		.add_fallback_present_mode(VK_PRESENT_MODE_FIFO_KHR)
+		.set_desired_extent(extent.width, extent.height)
+		//the present thread blits the render targets into the swapchain images
+		.add_image_usage_flags(m_AsyncPresent ? VK_IMAGE_USAGE_TRANSFER_DST_BIT : 0)
+		.set_old_swapchain(oldSwapchain)
 		.build()
 		.value();
 
+	if (m_AsyncPresent)
+	{
+		//the render targets are ours, the swapchain images never get a view or a framebuffer
+		m_Swapchain = vkbSwapchain.swapchain;
+		m_PresentImages = vkbSwapchain.get_images().value();
+		m_PresentExtent = vkbSwapchain.extent;
+		return;
+	}
+
+	//vkbootstrap quietly falls back to another format when the surface stops offering ours,
+	//the render pass was built for m_SwapchainImageFormat and can not render into anything else
+	if (vkbSwapchain.image_format != m_SurfaceFormat.format)
+	{
+		std::cout << "Swapchain was created with format " << vkbSwapchain.image_format << " instead of " << m_SurfaceFormat.format
+			<< ", the render pass no longer matches it" << std::endl;
+		abort();
+	}
+
 	//store swapchain and its related images
 	m_Swapchain = vkbSwapchain.swapchain;
 	m_SwapchainImages = vkbSwapchain.get_images().value();
 	m_SwapchainImageViews = vkbSwapchain.get_image_views().value();
 
-	m_SwapchainImageFormat  = vkbSwapchain.image_format;
+	//the surface decides the final size, which may differ from what we asked for
+	m_WindowExtent = vkbSwapchain.extent;
+}
+static const char* present_mode_name(VkPresentModeKHR mode)
+{
+	switch (mode)
+	{
+	case VK_PRESENT_MODE_IMMEDIATE_KHR: return "IMMEDIATE";
+	case VK_PRESENT_MODE_MAILBOX_KHR: return "MAILBOX";
+	case VK_PRESENT_MODE_FIFO_KHR: return "FIFO";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+	default: return "UNKNOWN";
+	}
+}
 
+void vkEngine::VulkanEngine::select_color_format()
+{
+	PROFILE_SCOPE("select_color_format");
+	//without a surface we pick the format ourselves, 8 bit BGRA matches what most swapchains hand out
+	m_SurfaceFormat = { VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
 
-		m_MainDeletionQueue.push_function([=]() {
-		vkDestroySwapchainKHR(m_Device, m_Swapchain, nullptr);
-	});
+	if (!m_Headless)
+	{
+		uint32_t formatCount = 0;
+		VK_CHECK(vkGetPhysicalDeviceSurfaceFormatsKHR(m_TargetGPU, m_vkSurface, &formatCount, nullptr));
+		std::vector<VkSurfaceFormatKHR> formats(formatCount);
+		VK_CHECK(vkGetPhysicalDeviceSurfaceFormatsKHR(m_TargetGPU, m_vkSurface, &formatCount, formats.data()));
+
+		//same preference as vkbootstrap's default selection, falling back to the first format the surface lists
+		const VkFormat preferred[] = { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB };
+		if (!formats.empty())
+			m_SurfaceFormat = formats[0];
+		for (VkFormat format : preferred)
+		{
+			auto found = std::find_if(formats.begin(), formats.end(), [=](const VkSurfaceFormatKHR& surfaceFormat) {
+				return surfaceFormat.format == format && surfaceFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+			});
+			if (found != formats.end())
+			{
+				m_SurfaceFormat = *found;
+				break;
+			}
+		}
+	}
 
+	//the present thread blits our own targets into the swapchain, those keep the headless format
+	m_SwapchainImageFormat = (m_Headless || m_AsyncPresent) ? VK_FORMAT_B8G8R8A8_UNORM : m_SurfaceFormat.format;
 }
-void vkEngine::VulkanEngine::init_vulkan()
+VkPresentModeKHR vkEngine::VulkanEngine::select_present_mode(VkPresentModeKHR requested)
 {
+	uint32_t modeCount = 0;
+	VK_CHECK(vkGetPhysicalDeviceSurfacePresentModesKHR(m_TargetGPU, m_vkSurface, &modeCount, nullptr));
+	std::vector<VkPresentModeKHR> modes(modeCount);
+	VK_CHECK(vkGetPhysicalDeviceSurfacePresentModesKHR(m_TargetGPU, m_vkSurface, &modeCount, modes.data()));
+
+	VkPresentModeKHR selected = VK_PRESENT_MODE_FIFO_KHR;
+	if (std::find(modes.begin(), modes.end(), requested) != modes.end())
+	{
+		selected = requested;
+	}
+	else
+	{
+		std::cout << "Present mode " << present_mode_name(requested) << " is not supported by the surface, falling back to FIFO" << std::endl;
+	}
+
+	std::cout << "Using present mode " << present_mode_name(selected) << std::endl;
+	return selected;
+}
+void vkEngine::VulkanEngine::recreate_swapchain(VkExtent2D drawableExtent)
+{
+	PROFILE_SCOPE("recreate_swapchain");
+	//zero sized while minimized, try again once the window comes back
+	if (drawableExtent.width == 0 || drawableExtent.height == 0)
+	{
+		m_SwapchainDirty = true;
+		return;
+	}
+
+	//on the present thread only the swapchain itself changes, the render targets keep their size and the blit scales them
+	if (m_AsyncPresent)
+	{
+		VkSwapchainKHR oldSwapchain = m_Swapchain;
+		m_PresentDeletionQueue.push(m_PresentTimeline.last_submitted_value() + m_FramesInFlight, m_Device, oldSwapchain);
+
+		create_swapchain(oldSwapchain, drawableExtent);
+
+		m_SwapchainDirty = false;
+		return;
+	}
+
+	m_WindowExtent = drawableExtent;
+
+	VkSwapchainKHR oldSwapchain = m_Swapchain;
+	std::vector<VkImageView> oldImageViews = std::move(m_SwapchainImageViews);
+	std::vector<VkFramebuffer> oldFramebuffers = std::move(m_Framebuffers);
+
+	//frames still in flight may reference the old objects, so retire them instead of waiting for the device.
+	//the GPU finishing our frames says nothing about the present engine, so the swapchain itself
+	//is kept around for one more trip through the frame ring before it goes away
+	uint64_t retireValue = m_GraphicsTimeline.last_submitted_value() + m_FramesInFlight;
+	for (VkFramebuffer framebuffer : oldFramebuffers)
+		m_FrameDeletionQueue.push(retireValue, m_Device, framebuffer);
+	for (VkImageView imageView : oldImageViews)
+		m_FrameDeletionQueue.push(retireValue, m_Device, imageView);
+	m_FrameDeletionQueue.push(retireValue, m_Device, oldSwapchain);
+
+	//only the swapchain, its views and the framebuffers depend on the window size.
+	//the format stays the one select_color_format picked, create_swapchain checks the new swapchain against it
+	create_swapchain(oldSwapchain, m_WindowExtent);
+
+	create_framebuffers();
+
+	m_SwapchainDirty = false;
+}
+void vkEngine::VulkanEngine::init_offscreen_targets(DeletionQueue& deletionQueue)
+{
+	PROFILE_SCOPE("init_offscreen_targets");
+	VkExtent3D extent = { m_WindowExtent.width, m_WindowExtent.height, 1 };
+
+	//transfer source so the result can be copied out for inspection
+	VkImageCreateInfo imageInfo = vkInit::image_create_info(m_SwapchainImageFormat,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, extent);
+
+	//the images only ever live in VRAM
+	VmaAllocationCreateInfo allocInfo = {};
+	allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+	m_OffscreenImages.resize(m_FramesInFlight);
+	m_SwapchainImages.resize(m_FramesInFlight);
+	m_SwapchainImageViews.resize(m_FramesInFlight);
+
+	for (uint32_t i = 0; i < m_FramesInFlight; i++)
+	{
+		VK_CHECK(vmaCreateImage(m_Allocator, &imageInfo, &allocInfo, &m_OffscreenImages[i].m_Image, &m_OffscreenImages[i].m_Allocation, nullptr));
+		m_SwapchainImages[i] = m_OffscreenImages[i].m_Image;
+
+		//the views are destroyed together with the framebuffers, same as swapchain views
+		VkImageViewCreateInfo viewInfo = vkInit::imageview_create_info(m_SwapchainImageFormat, m_SwapchainImages[i], VK_IMAGE_ASPECT_COLOR_BIT);
+		VK_CHECK(vkCreateImageView(m_Device, &viewInfo, nullptr, &m_SwapchainImageViews[i]));
+
+		deletionQueue.push_image(m_Allocator, m_OffscreenImages[i].m_Image, m_OffscreenImages[i].m_Allocation);
+	}
+}
+void vkEngine::VulkanEngine::init_vulkan(DeletionQueue& deletionQueue)
+{
+	PROFILE_SCOPE("init_vulkan");
+	//finds the loader, only the global entry points are usable until an instance is loaded
+	VK_CHECK(volkInitialize());
+
 	vkb::InstanceBuilder builder;
 
-	//make the Vulkan instance, with basic debug features
-	auto inst_ret = builder.set_app_name("Vulkan App")
-		.request_validation_layers(true)
-		.require_api_version(1, 1, 0)
-		.use_default_debug_messenger()
-		.build();
+	//make the Vulkan instance, with basic debug features unless they were turned off
+	builder.set_app_name("Vulkan App")
+		.request_validation_layers(m_Validation)
+		.require_api_version(1, 2, 0)
+		//headless skips the surface extensions, which display-less machines may not have
+		.set_headless(m_Headless);
+	if (m_Validation)
+		builder.use_default_debug_messenger();
+	auto inst_ret = builder.build();
 
 	vkb::Instance vkb_inst = inst_ret.value();
 
@@ -277,36 +1166,72 @@ void vkEngine::VulkanEngine::init_vulkan()
 	//store the debug messenger
 	m_DebugMessanger = vkb_inst.debug_messenger;
 
-		// get the surface of the window we opened with SDL
-	SDL_Vulkan_CreateSurface(m_Window, m_Instance, &m_vkSurface);
+	//instance level entry points, device level ones still go through the loader's trampolines for now
+	volkLoadInstance(m_Instance);
 
 	//use vkbootstrap to select a GPU.
-	//We want a GPU that can write to the SDL surface and supports Vulkan 1.1
+	//We want a GPU that can write to the SDL surface and supports Vulkan 1.2, which makes timeline semaphores core
 	vkb::PhysicalDeviceSelector selector{ vkb_inst };
+	selector.set_minimum_version(1, 2);
+
+	if (m_Headless)
+	{
+		//any device will do, presentation support is not required
+		m_vkSurface = VK_NULL_HANDLE;
+	}
+	else
+	{
+		// get the surface of the window we opened with SDL
+		SDL_Vulkan_CreateSurface(m_Window, m_Instance, &m_vkSurface);
+		selector.set_surface(m_vkSurface);
+	}
+
 	vkb::PhysicalDevice physicalDevice = selector
-		.set_minimum_version(1, 1)
-		.set_surface(m_vkSurface)
 		.select()
 		.value();
 
 	//create the final Vulkan device
 	vkb::DeviceBuilder deviceBuilder{ physicalDevice };
 
-	vkb::Device vkbDevice = deviceBuilder.build().value();
+	//timeline semaphores are mandatory in 1.2 but still have to be enabled
+	VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = {};
+	timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+	timelineFeatures.pNext = nullptr;
+	timelineFeatures.timelineSemaphore = VK_TRUE;
+
+	vkb::Device vkbDevice = deviceBuilder
+		.add_pNext(&timelineFeatures)
+		.build()
+		.value();
 
 	// Get the VkDevice handle used in the rest of a Vulkan application
 	m_Device = vkbDevice.device;
 	m_TargetGPU = physicalDevice.physical_device;
 
+	//point every device level entry point at the driver, vkCmd* and vkQueue* calls skip the loader's dispatch from here on.
+	//there is only ever one device, so the global pointers are enough
+	volkLoadDevice(m_Device);
+
 
 	// use vkbootstrap to get a Graphics queue
 	m_GraphicsQueue = vkbDevice.get_queue(vkb::QueueType::graphics).value();
 	m_GraphicsQueueFamily = vkbDevice.get_queue_index(vkb::QueueType::graphics).value();
 
+	//initialize the memory allocator
+	VmaAllocatorCreateInfo allocatorInfo = {};
+	allocatorInfo.physicalDevice = m_TargetGPU;
+	allocatorInfo.device = m_Device;
+	allocatorInfo.instance = m_Instance;
+	VK_CHECK(vmaCreateAllocator(&allocatorInfo, &m_Allocator));
+
+	deletionQueue.push_function([=]() {
+		vmaDestroyAllocator(m_Allocator);
+	});
 }
 
-void vkEngine::VulkanEngine::init_default_renderpass()
+void vkEngine::VulkanEngine::init_default_renderpass(DeletionQueue& deletionQueue)
 {
+	PROFILE_SCOPE("init_default_renderpass");
 
 
 	// the renderpass will use this color attachment.
@@ -328,7 +1253,8 @@ void vkEngine::VulkanEngine::init_default_renderpass()
 	color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
 	//after the renderpass ends, the image has to be on a layout ready for display
-	color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	//offscreen targets are never presented, so leave them ready to be copied out instead
+	color_attachment.finalLayout = (m_Headless || m_AsyncPresent) ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 
 
@@ -364,13 +1290,25 @@ void vkEngine::VulkanEngine::init_default_renderpass()
 	VK_CHECK(vkCreateRenderPass(m_Device, &render_pass_info, nullptr, &m_RenderPass));
 
 
-	m_MainDeletionQueue.push_function([=]() {
-		vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
-    });
+	deletionQueue.push(m_Device, m_RenderPass);
  
 
  } 
-void vkEngine::VulkanEngine::init_framebuffers()
+void vkEngine::VulkanEngine::init_framebuffers(DeletionQueue& deletionQueue)
+{
+	PROFILE_SCOPE("init_framebuffers");
+	create_framebuffers();
+
+	//destroys whatever framebuffers and views are current at shutdown, the swapchain may have been rebuilt since
+	deletionQueue.push_function([=]() {
+		for (size_t i = 0; i < m_Framebuffers.size(); i++)
+		{
+			vkDestroyFramebuffer(m_Device, m_Framebuffers[i], nullptr);
+			vkDestroyImageView(m_Device, m_SwapchainImageViews[i], nullptr);
+		}
+	});
+}
+void vkEngine::VulkanEngine::create_framebuffers()
 {	
 	VkFramebufferCreateInfo fb_info = {};
 	fb_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -391,54 +1329,104 @@ void vkEngine::VulkanEngine::init_framebuffers()
 
 		fb_info.pAttachments = &m_SwapchainImageViews[i];
 		VK_CHECK(vkCreateFramebuffer(m_Device, &fb_info, nullptr, &m_Framebuffers[i]));
+	}
 
-		m_MainDeletionQueue.push_function([=]() {
-			vkDestroyFramebuffer(m_Device, m_Framebuffers[i], nullptr);
-			vkDestroyImageView(m_Device, m_SwapchainImageViews[i], nullptr);
-    	});
+}
+
+void vkEngine::VulkanEngine::init_sync_structures(DeletionQueue& deletionQueue)
+{
+	PROFILE_SCOPE("init_sync_structures");
+	//the timeline starts at 0, which every frame slot treats as an already finished frame
+	m_GraphicsTimeline.init(m_Device);
+
+	m_PresentTimeline.init(m_Device);
+
+	deletionQueue.push_function([=]() {
+		m_GraphicsTimeline.destroy();
+		m_PresentTimeline.destroy();
+	});
+
+	//for the semaphores we don't need any flags
+	VkSemaphoreCreateInfo semaphoreCreateInfo = vkInit::semaphore_create_info();
+
+	for (uint32_t i = 0; i < m_FramesInFlight; i++)
+	{
+		VK_CHECK(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &m_Frames[i].m_PresentSemaphore));
+		VK_CHECK(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &m_Frames[i].m_RenderSemaphore));
+
+		//enqueue the destruction of semaphores
+		deletionQueue.push(m_Device, m_Frames[i].m_PresentSemaphore);
+		deletionQueue.push(m_Device, m_Frames[i].m_RenderSemaphore);
 	}
 
 }
 
-void vkEngine::VulkanEngine::init_sync_structures()
+void vkEngine::VulkanEngine::init_descriptors(DeletionQueue& deletionQueue)
 {
-	VkFenceCreateInfo fenceCreateInfo = {};
-	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceCreateInfo.pNext = nullptr;
+	PROFILE_SCOPE("init_descriptors");
+	VkDescriptorSetLayoutBinding frameBinding = vkInit::descriptorset_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0);
 
-	//we want to create the fence with the Create Signaled flag, so we can wait on it before using it on a GPU command (for the first frame)
-	fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+	//the same binding the triangle shaders reflect to, so their pipeline layout reuses this set layout
+	m_FrameSetLayout = m_LayoutCache.get_set_layout({ frameBinding });
+	if (m_FrameSetLayout == VK_NULL_HANDLE)
+	{
+		std::cout << "Failed to create the frame descriptor set layout" << std::endl;
+		abort();
+	}
 
-	VK_CHECK(vkCreateFence(m_Device, &fenceCreateInfo, nullptr, &m_RenderFence));
+	//one uniform slot per frame in flight
+	VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, MAX_FRAMES_IN_FLIGHT };
 
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.pNext = nullptr;
 
-	//enqueue the destruction of the fence
-    m_MainDeletionQueue.push_function([=]() {
-        vkDestroyFence(m_Device, m_RenderFence, nullptr);
-    });
+	poolInfo.flags = 0;
+	poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
 
-	//for the semaphores we don't need any flags
-	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
-	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-	semaphoreCreateInfo.pNext = nullptr;
-	semaphoreCreateInfo.flags = 0;
+	VK_CHECK(vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_DescriptorPool));
 
-	VK_CHECK(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &m_PresentSemaphore));
-	VK_CHECK(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &m_RenderSemaphore));
+	deletionQueue.push(m_Device, m_DescriptorPool);
 
+	VkBufferCreateInfo bufferInfo = vkInit::buffer_create_info(sizeof(FrameUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+	//host visible and mapped for the whole lifetime of the buffer, writing the slot is just a memcpy
+	VmaAllocationCreateInfo allocInfo = {};
+	allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+	allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+	for (uint32_t i = 0; i < m_FramesInFlight; i++)
+	{
+		VmaAllocationInfo allocationInfo;
+		VK_CHECK(vmaCreateBuffer(m_Allocator, &bufferInfo, &allocInfo, &m_Frames[i].m_UniformBuffer.m_Buffer, &m_Frames[i].m_UniformBuffer.m_Allocation, &allocationInfo));
+		m_Frames[i].m_UniformData = allocationInfo.pMappedData;
 
-	//enqueue the destruction of semaphores
-    m_MainDeletionQueue.push_function([=]() {
-        vkDestroySemaphore(m_Device, m_PresentSemaphore, nullptr);
-        vkDestroySemaphore(m_Device, m_RenderSemaphore, nullptr);
-    });
+		deletionQueue.push_buffer(m_Allocator, m_Frames[i].m_UniformBuffer.m_Buffer, m_Frames[i].m_UniformBuffer.m_Allocation);
 
+		VkDescriptorSetAllocateInfo setAllocInfo = {};
+		setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		setAllocInfo.pNext = nullptr;
+
+		setAllocInfo.descriptorPool = m_DescriptorPool;
+		setAllocInfo.descriptorSetCount = 1;
+		setAllocInfo.pSetLayouts = &m_FrameSetLayout;
+
+		VK_CHECK(vkAllocateDescriptorSets(m_Device, &setAllocInfo, &m_Frames[i].m_FrameDescriptor));
+
+		VkDescriptorBufferInfo uniformInfo = { m_Frames[i].m_UniformBuffer.m_Buffer, 0, sizeof(FrameUniforms) };
+		VkWriteDescriptorSet write = vkInit::write_descriptor_buffer(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, m_Frames[i].m_FrameDescriptor, &uniformInfo, 0);
+
+		vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+	}
 }
 
-void vkEngine::VulkanEngine::init_pipeline()
+void vkEngine::VulkanEngine::init_pipeline(DeletionQueue& deletionQueue)
 {
+	PROFILE_SCOPE("init_pipeline");
 	VkShaderModule triangleVertexShader;
-	if (!load_shader_module("../../shaders/triangleShader.vert.spv", &triangleVertexShader))
+	if (!load_shader_module(SHADER_FILES[0], &triangleVertexShader))
 	{
 		std::cout << "Error when building the triangle vertex shader module" << std::endl;
 
@@ -449,7 +1437,7 @@ void vkEngine::VulkanEngine::init_pipeline()
 
 
 	VkShaderModule triangleFragShader;
-	if (!load_shader_module("../../shaders/triangleShader.frag.spv", &triangleFragShader))
+	if (!load_shader_module(SHADER_FILES[1], &triangleFragShader))
 	{
 		std::cout << "Error when building the triangle fragment shader module" << std::endl;
 	}
@@ -458,31 +1446,14 @@ void vkEngine::VulkanEngine::init_pipeline()
 	}
 	
 
-	VkShaderModule specialTriangleVertexShader;
-	if (!load_shader_module("../../shaders/specialTriangleShader.vert.spv", &specialTriangleVertexShader))
+	//the pipeline layout that controls the inputs/outputs of the shader comes from what the shaders declare,
+	//the only input is the per-frame uniform slot
+	m_TrianglePipelineLayout = m_LayoutCache.get_pipeline_layout({ m_ShaderCache.get_reflection(triangleVertexShader), m_ShaderCache.get_reflection(triangleFragShader) });
+	if (m_TrianglePipelineLayout == VK_NULL_HANDLE)
 	{
-	std::cout << "Error when building the triangle vertex shader module" << std::endl;
-	
+		std::cout << "Failed to reflect the triangle pipeline layout" << std::endl;
+		abort();
 	}
-	else {
-	std::cout << "Triangle vertex shader successfully loaded" << std::endl;
-	}
-	
-	
-	VkShaderModule specialTriangleFragShader;
-	if (!load_shader_module("../../shaders/specialTriangleShader.frag.spv", &specialTriangleFragShader))
-	{
-	std::cout << "Error when building the triangle fragment shader module" << std::endl;
-	}
-	else {
-	std::cout << "Triangle fragment shader successfully loaded" << std::endl;
-	}
-	
-	//build the pipeline layout that controls the inputs/outputs of the shader
-	//we are not using descriptor sets or other systems yet, so no need to use anything other than empty default
-	VkPipelineLayoutCreateInfo pipeline_layout_info = vkInit::pipeline_layout_create_info();
-
-	VK_CHECK(vkCreatePipelineLayout(m_Device, &pipeline_layout_info, nullptr, &m_TrianglePipelineLayout));
 
 
 		//build the stage-create-info for both vertex and fragment stages. This lets the pipeline know the shader modules per stage
@@ -502,16 +1473,8 @@ void vkEngine::VulkanEngine::init_pipeline()
 	//we are just going to draw triangle list
 	pipelineBuilder.m_InputAssembly = vkInit::input_assembly_create_info(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
 
-	//build viewport and scissor from the swapchain extents
-	pipelineBuilder.m_Viewport.x = 0.0f;
-	pipelineBuilder.m_Viewport.y = 0.0f;
-	pipelineBuilder.m_Viewport.width = (float) m_WindowExtent.width;
-	pipelineBuilder.m_Viewport.height = (float)m_WindowExtent.height;
-	pipelineBuilder.m_Viewport.minDepth = 0.0f;
-	pipelineBuilder.m_Viewport.maxDepth = 1.0f;
-
-	pipelineBuilder.m_Scissor.offset = { 0, 0 };
-	pipelineBuilder.m_Scissor.extent = m_WindowExtent;
+	//viewport and scissor are dynamic, draw() sets them from the render target it draws into
+	pipelineBuilder.m_DynamicViewport = true;
 
 	//configure the rasterizer to draw filled triangles
 	pipelineBuilder.m_Rasterizer = vkInit::rasterization_state_create_info(VK_POLYGON_MODE_FILL);
@@ -526,144 +1489,122 @@ void vkEngine::VulkanEngine::init_pipeline()
 	pipelineBuilder.m_PipelineLayout = m_TrianglePipelineLayout;
 	
 
-	//finally build the pipeline
-	m_TrianglePipeline = pipelineBuilder.build_pipeline(m_Device, m_RenderPass);
-
-	//clear the shader stages for the builder
-	pipelineBuilder.m_ShaderStages.clear();
-
-	//add the other shaders
-	pipelineBuilder.m_ShaderStages.push_back(
-		vkInit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_VERTEX_BIT, specialTriangleVertexShader));
-
-
-	pipelineBuilder.m_ShaderStages.push_back(
-		vkInit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_FRAGMENT_BIT, specialTriangleFragShader));
-
-	m_SpecialTrianglePipeline = pipelineBuilder.build_pipeline(m_Device, m_RenderPass);
-
-
+	//the triangle variants only differ in FLAT_COLOR of the fragment shader, space cycles through them in this order.
+	//the first one is built now and drawn with until the others finish compiling on the workers
+	m_PipelineRegistry.init(m_Device, m_PipelineCache.get());
+	auto buildStart = std::chrono::steady_clock::now();
+	bool builtFallback = m_TrianglePermutations.init(m_PipelineRegistry, m_JobSystem, m_RenderPass, pipelineBuilder,
+		{ SHADER_FILES[0], SHADER_FILES[1] }, { { VK_FALSE }, { VK_TRUE } });
+	m_PipelineBuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
 
-	//destroy all shader modules, outside of the queue
-	vkDestroyShaderModule(m_Device, specialTriangleVertexShader, nullptr);
-	vkDestroyShaderModule(m_Device, specialTriangleFragShader, nullptr);
-	vkDestroyShaderModule(m_Device, triangleFragShader, nullptr);
-	vkDestroyShaderModule(m_Device, triangleVertexShader, nullptr);
+	//the modules stay in the shader cache, later variants of these pipelines reuse them
 
- 	m_MainDeletionQueue.push_function([=]() {
-		//destroy the 2 pipelines we have created
-		vkDestroyPipeline(m_Device, m_SpecialTrianglePipeline, nullptr);
-        vkDestroyPipeline(m_Device, m_TrianglePipeline, nullptr);
+	//the layouts belong to the layout cache, which is destroyed after the registry's pipelines
+	deletionQueue.push_function([=]() {
+		m_PipelineRegistry.destroy();
+	});
 
-		//destroy the pipeline layout that they use
-		vkDestroyPipelineLayout(m_Device, m_TrianglePipelineLayout, nullptr);
-    });
+	if (!builtFallback)
+	{
+		std::cout << "Failed to build the triangle pipeline" << std::endl;
+		abort();
+	}
 
 }
 
 bool vkEngine::VulkanEngine::load_shader_module(const char* filePath, VkShaderModule* outShaderModule)
 {
-	//open the file. With cursor at the end
-	std::ifstream file(filePath, std::ios::ate | std::ios::binary);
-
-	if (!file.is_open()) 
-	{
+	PROFILE_SCOPE("load_shader_module");
+	//shared with every other pipeline using the same code, the cache destroys it on cleanup
+	VkShaderModule shaderModule = m_ShaderCache.get(filePath);
+	if (shaderModule == VK_NULL_HANDLE) {
 		return false;
 	}
-	//find what the size of the file is by looking up the location of the cursor
-	//because the cursor is at the end, it gives the size directly in bytes
-	size_t fileSize = (size_t)file.tellg();
+	*outShaderModule = shaderModule;
+	return true;
+}
 
-	//spirv expects the buffer to be on uint32, so make sure to reserve an int vector big enough for the entire file
-	std::vector<uint32_t> buffer(fileSize / sizeof(uint32_t));
+void vkEngine::VulkanEngine::reload_shader(const std::string& spirvPath)
+{
+	PROFILE_SCOPE("reload_shader");
+	auto start = std::chrono::steady_clock::now();
 
-	//put file cursor at beginning
-	file.seekg(0);
+	//the watcher names the file differently than the paths the pipelines were built from
+	std::string fileName = spirvPath.substr(spirvPath.find_last_of("/\\") + 1);
 
-	//load the entire file into the buffer
-	file.read((char*)buffer.data(), fileSize);
+	VkShaderModule shaderModule = m_ShaderCache.get_from_file(spirvPath.c_str());
+	if (shaderModule == VK_NULL_HANDLE)
+	{
+		std::cout << "Failed to load the reloaded shader " << spirvPath << std::endl;
+		return;
+	}
 
-	//now that the file is loaded into the buffer, we can close it
-	file.close();
+	PipelineBuilder base;
+	if (!m_TrianglePermutations.with_shader(fileName, shaderModule, base))
+		return;
 
+	std::vector<const ShaderReflection*> reflections;
+	for (const VkPipelineShaderStageCreateInfo& stage : base.m_ShaderStages)
+		reflections.push_back(m_ShaderCache.get_reflection(stage.module));
 
+	//the descriptor sets draw() binds were made for the layout the pipeline started with
+	if (m_LayoutCache.get_pipeline_layout(reflections) != base.m_PipelineLayout)
+	{
+		std::cout << fileName << " changes the resources its pipeline uses, restart to pick it up" << std::endl;
+		return;
+	}
 
-	//create a new shader module, using the buffer we loaded
-	VkShaderModuleCreateInfo createInfo = {};
-	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.pNext = nullptr;
+	//variants that were never shown are compiled from the new base when they are first used
+	std::vector<std::pair<PipelineId, PipelineBuilder>> variants = m_TrianglePermutations.set_base(base);
+	std::vector<PipelineBuilder> builders;
+	for (const auto& variant : variants)
+		builders.push_back(variant.second);
 
-	//codeSize has to be in bytes, so multiply the ints in the buffer by size of int to know the real size of the buffer
-	createInfo.codeSize = buffer.size() * sizeof(uint32_t);
-	createInfo.pCode = buffer.data();
+	std::vector<VkPipeline> pipelines = PipelineBuilder::build_pipelines(m_Device, m_RenderPass, m_PipelineCache.get(), builders, m_JobSystem);
 
-	//check that the creation goes well.
-	VkShaderModule shaderModule;
-	if (vkCreateShaderModule(m_Device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-		return false;
+	std::vector<ReloadedPipeline> reloaded;
+	for (size_t i = 0; i < variants.size(); i++)
+	{
+		//a variant that fails keeps its previous pipeline
+		if (pipelines[i] != VK_NULL_HANDLE)
+			reloaded.push_back({ variants[i].first, pipelines[i] });
 	}
-	*outShaderModule = shaderModule;
-	return true;
+
+	if (reloaded.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_ReloadMutex);
+		m_ReloadedPipelines.insert(m_ReloadedPipelines.end(), reloaded.begin(), reloaded.end());
+		m_HasReloadedPipelines.store(true, std::memory_order_release);
+	}
+
+	double reloadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Reloaded " << fileName << ", rebuilt " << reloaded.size() << " pipelines in " << reloadMs << " ms" << std::endl;
 }
 
-VkPipeline vkEngine::PipelineBuilder::build_pipeline(VkDevice device, VkRenderPass pass)
+void vkEngine::VulkanEngine::swap_reloaded_pipelines()
 {
+	if (!m_HasReloadedPipelines.load(std::memory_order_acquire))
+		return;
 
-			//make viewport state from our stored viewport and scissor.
-			//at the moment we won't support multiple viewports or scissors
-
-			VkPipelineViewportStateCreateInfo viewportState = {};
-			viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-			viewportState.pNext = nullptr;
-
-			viewportState.viewportCount = 1;
-			viewportState.pViewports = &m_Viewport;
-			viewportState.scissorCount = 1;
-			viewportState.pScissors = &m_Scissor;
-
-			//setup dummy color blending. We aren't using transparent objects yet
-			//the blending is just "no blend", but we do write to the color attachment
-			VkPipelineColorBlendStateCreateInfo colorBlending = {};
-			colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-			colorBlending.pNext = nullptr;
-
-			colorBlending.logicOpEnable = VK_FALSE;
-			colorBlending.logicOp = VK_LOGIC_OP_COPY;
-			colorBlending.attachmentCount = 1;
-			colorBlending.pAttachments = &m_ColorBlendAttachment;
-
-
-
-			//build the actual pipeline
-			//we now use all of the info structs we have been writing into into this one to create the pipeline
-			VkGraphicsPipelineCreateInfo pipelineInfo = {};
-			pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-			pipelineInfo.pNext = nullptr;
-
-			pipelineInfo.stageCount = m_ShaderStages.size();
-			pipelineInfo.pStages = m_ShaderStages.data();
-			pipelineInfo.pVertexInputState = &m_VertexInputInfo;
-			pipelineInfo.pInputAssemblyState = &m_InputAssembly;
-			pipelineInfo.pViewportState = &viewportState;
-			pipelineInfo.pRasterizationState = &m_Rasterizer;
-			pipelineInfo.pMultisampleState = &m_Multisampling;
-			pipelineInfo.pColorBlendState = &colorBlending;
-			pipelineInfo.layout = m_PipelineLayout;
-			pipelineInfo.renderPass = pass;
-			pipelineInfo.subpass = 0;
-			pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-
-			//it's easy to error out on create graphics pipeline, so we handle it a bit better than the common VK_CHECK case
-			VkPipeline newPipeline;
-			if (vkCreateGraphicsPipelines(
-				device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &newPipeline) != VK_SUCCESS) {
-				std::cout << "failed to create pipeline\n";
-				return VK_NULL_HANDLE; // failed to create graphics pipeline
-			}
-			else
-			{
-				return newPipeline;
-			}
+	std::vector<ReloadedPipeline> reloaded;
+	{
+		std::lock_guard<std::mutex> lock(m_ReloadMutex);
+		reloaded.swap(m_ReloadedPipelines);
+		m_HasReloadedPipelines.store(false, std::memory_order_relaxed);
+	}
 
+	//frames already submitted may still be drawing with the old pipelines
+	uint64_t retireValue = m_GraphicsTimeline.last_submitted_value();
+	for (const ReloadedPipeline& pipeline : reloaded)
+	{
+		VkPipeline previous = m_PipelineRegistry.replace(pipeline.m_Id, pipeline.m_Pipeline);
+		m_FrameDeletionQueue.push(retireValue, m_Device, previous);
+	}
+}
 
+vkEngine::FrameData& vkEngine::VulkanEngine::get_current_frame()
+{
+	return m_Frames[m_FrameNumber % m_FramesInFlight];
 }
@@ -4,70 +4,284 @@
 #pragma once
 
 #include <vkTypes.h>
+#include <vkFrameLimiter.h>
+#include <vkTimeline.h>
+#include <vkDeletionQueue.h>
+#include <vkTripleBuffer.h>
+#include <vkFrameStats.h>
+#include <vkGpuProfiler.h>
+#include <vkJobSystem.h>
+#include <vkPipelineCache.h>
+#include <vkPipelineRegistry.h>
+#include <vkShaderCache.h>
+#include <vkLayoutCache.h>
+#include <vkShaderWatcher.h>
+#include <vkPipelineBuilder.h>
+#include <vkPipelinePermutations.h>
 #include <vector>
 #include <deque>
 #include <functional>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <glm/glm.hpp>
 struct SDL_Window;
 
 namespace vkEngine {
 
-	struct DeletionQueue
+	//contents of the per-frame uniform slot, set 0 binding 0 of every pipeline
+	struct FrameUniforms
 	{
-	public:
-		void push_function(std::function<void()>&& function) 
-		{
-			deletors.push_back(function);
-		}
+		glm::mat4 m_Transform;
+	};
 
-		void flush() 
-		{
-			// reverse iterate the deletion queue to execute all the functions
-			for (auto it = deletors.rbegin(); it != deletors.rend(); it++) {
-				(*it)(); //call the function
-			}
-
-			deletors.clear();
-		}
-	private: 
-		std::deque<std::function<void()>> deletors;
+	//upper bound for the frame ring, the actual depth is picked at init time
+	constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
+	//everything the CPU needs to record and submit one frame while the GPU is still busy with the previous ones
+	struct FrameData
+	{
+		//binary semaphores, the swapchain does not accept timeline ones
+		VkSemaphore m_PresentSemaphore, m_RenderSemaphore;
+
+		//graphics timeline value signaled when this slot's last submission finished, 0 means never submitted
+		uint64_t m_TimelineValue{ 0 };
+
+		VkCommandPool m_CommandPool;
+		VkCommandBuffer m_MainCommandBuffer;
+
+		//persistently mapped uniform slot, written just before the frame is submitted
+		AllocatedBuffer m_UniformBuffer;
+		void* m_UniformData;
+		VkDescriptorSet m_FrameDescriptor;
+
+		//used by the present thread to copy this slot's render target into the swapchain
+		VkCommandPool m_PresentCommandPool;
+		VkCommandBuffer m_PresentCommandBuffer;
+	};
+
+	//game state one frame is rendered from. the main thread fills it from input and window events,
+	//once handed to the renderer it is never modified
+	struct FrameSnapshot
+	{
+		uint32_t m_ShaderIndex{ 0 };
+
+		//window state, the resize counter is bumped on every change so a skipped snapshot can not lose a resize
+		VkExtent2D m_DrawableExtent{ 0, 0 };
+		uint32_t m_ResizeCount{ 0 };
+		bool m_Minimized{ false };
+
+		//mouse position in normalized device coordinates
+		glm::vec2 m_Pointer{ 0.f, 0.f };
+
+		//when the input this snapshot is based on was sampled
+		FrameLimiter::Clock::time_point m_InputTime{};
+	};
+
+	//the newest input available at the moment the uniform slot is written
+	struct LatchedInput
+	{
+		glm::vec2 m_Pointer;
+		FrameLimiter::Clock::time_point m_SampleTime;
+	};
+
+	//a finished frame handed from the recording thread to the present thread
+	struct PresentRequest
+	{
+		uint32_t m_Slot;
+		//graphics timeline value signaled once the frame finished rendering
+		uint64_t m_TimelineValue;
+
+		VkExtent2D m_DrawableExtent;
+		uint32_t m_ResizeCount;
+		FrameLimiter::Clock::time_point m_InputTime;
+	};
+
+	struct EngineConfig
+	{
+		//how many frames the CPU may record ahead of the GPU, clamped to [1, MAX_FRAMES_IN_FLIGHT]
+		uint32_t framesInFlight{ 2 };
+
+		//render into engine-owned images instead of a window swapchain, no SDL video or surface is created
+		bool headless{ false };
+
+		//enable the validation layers and the debug messenger, benchmarks turn them off so every call goes straight to the driver
+		bool validation{ true };
+
+		//size of the window, or of the offscreen targets when headless
+		VkExtent2D windowExtent{ 1240 , 720 };
+
+		//stop the main loop after this many frames, 0 runs until the window is closed
+		uint64_t maxFrames{ 0 };
+
+		//preferred present mode, falls back to FIFO when the surface does not support it
+		VkPresentModeKHR presentMode{ VK_PRESENT_MODE_FIFO_KHR };
+
+		//minimum time between frames in milliseconds, 0 leaves the loop uncapped
+		double targetFrameTimeMs{ 0.0 };
+
+		//render on a dedicated thread, the main thread keeps polling SDL and publishes snapshots to it
+		bool threaded{ false };
+
+		//acquire and present on a dedicated thread, frames are rendered offscreen and copied into the swapchain there
+		bool asyncPresent{ false };
+
+		//sample input again right before submit instead of using what was current when recording started
+		bool lateLatch{ true };
+
+		//run independent init steps on worker threads, off runs them one after another on the main thread
+		bool parallelInit{ true };
+
+		//build pipelines from the SPIR-V compiled into the executable, off loads the .spv files from disk
+		bool embeddedShaders{ true };
+
+		//recompile shaders/ whenever a source changes and swap the rebuilt pipelines in while running
+		bool hotReload{ false };
+
+		//pipeline cache file, loaded at init and written back on cleanup. empty keeps the cache in memory only
+		std::string pipelineCachePath{ "pipeline_cache.bin" };
+
+		//where to dump the per-frame timings on exit, nothing is written when empty
+		std::string statsCsvPath;
+		std::string statsJsonPath;
 	};
 
 	class VulkanEngine {
 	public:
 		//initializes everything in the engine
-		void init();
+		void init(const EngineConfig& config = {});
 		//shuts down the engine
 		void cleanup();
 		//draw loop
-		void draw();
+		void draw(const FrameSnapshot& snapshot);
 		//run main loop
 		void run();
+		//runs the named micro-benchmark instead of the main loop. Returns false if there is no such benchmark
+		bool run_benchmark(const char* name);
 
 	private:
-		void init_commands();
+		//closes a draw() phase in the frame stats and the trace. Returns the end of the phase
+		FrameStats::Clock::time_point end_phase(uint32_t timer, const char* traceName, FrameStats::Clock::time_point start);
+
+		//applies pending SDL events to the game state. Returns true when the user asked to quit
+		bool process_events(FrameSnapshot& state);
+
+		//body of the render thread in threaded mode, draws the latest published snapshot until asked to quit
+		void render_loop();
+
+		//body of the present thread, presents every queued frame until stop_present_thread() is called
+		void present_loop();
+
+		//acquires a swapchain image, copies the frame's render target into it and presents it
+		void present_frame(const PresentRequest& request);
+
+		//lets the present thread drain its queue and joins it
+		void stop_present_thread();
+
+		void init_commands(DeletionQueue& deletionQueue);
+
+		void init_swapchain(DeletionQueue& deletionQueue);
 
-		void init_swapchain();
+		//builds the swapchain and its image views, handing oldSwapchain to the driver so it can reuse its resources
+		void create_swapchain(VkSwapchainKHR oldSwapchain, VkExtent2D extent);
 
-		void init_vulkan();
+		//replaces the swapchain after a resize or an out-of-date result without waiting for the device to go idle
+		void recreate_swapchain(VkExtent2D drawableExtent);
 
-		void init_default_renderpass();
+		//returns the requested present mode if the surface supports it, FIFO otherwise
+		VkPresentModeKHR select_present_mode(VkPresentModeKHR requested);
 
-		void init_framebuffers();
+		//picks the surface format and the format we render in, so the render pass does not have to wait for the swapchain
+		void select_color_format();
+
+		//headless replacement for the swapchain, one engine-owned color target per frame slot
+		void init_offscreen_targets(DeletionQueue& deletionQueue);
+
+		void init_vulkan(DeletionQueue& deletionQueue);
+
+		void init_default_renderpass(DeletionQueue& deletionQueue);
+
+		void init_framebuffers(DeletionQueue& deletionQueue);
+
+		void create_framebuffers();
 	
-		void init_sync_structures();
+		void init_sync_structures(DeletionQueue& deletionQueue);
 
-		void init_pipeline();
+		void init_descriptors(DeletionQueue& deletionQueue);
 
-		//loads a shader module from a spir-v file. Returns false if it errors
+		void init_pipeline(DeletionQueue& deletionQueue);
+
+		//reads the newest input without consuming any events
+		LatchedInput sample_latest_input();
+
+		//writes the frame's uniform slot, late latched or from the snapshot. Returns when the input it used was sampled
+		FrameLimiter::Clock::time_point latch_frame_uniforms(FrameData& frame, const FrameSnapshot& snapshot);
+
+		//gets the shader module for a spir-v file from the shader cache. Returns false if it errors
 		bool load_shader_module(const char* filePath, VkShaderModule* outShaderModule);
 
+		//watcher thread, rebuilds every shader pipeline using the recompiled file. the next draw() swaps them in
+		void reload_shader(const std::string& spirvPath);
+
+		//puts the pipelines reload_shader rebuilt into the registry and retires the ones they replace
+		void swap_reloaded_pipelines();
+
+		//frame slot used for the frame currently being recorded
+		FrameData& get_current_frame();
 
 	private:
+		//written by the render_targets init step when the swapchain picks its size, init steps reading it must run after that one
 		VkExtent2D m_WindowExtent{ 1240 , 720 };
 		SDL_Window* m_Window{ nullptr };
 		bool m_IsInitialized{ false };
-		int m_FrameNumber{ 0 };
-		uint32_t m_ShaderIndex{0};
+		bool m_Headless{ false };
+		bool m_Validation{ true };
+		bool m_Threaded{ false };
+		bool m_AsyncPresent{ false };
+		bool m_LateLatch{ true };
+
+		//how old the input was at submit, with and without the late latch
+		uint64_t m_LatchSamples{ 0 };
+		double m_StaleInputAgeSumMs{ 0.0 };
+		double m_LatchedInputAgeSumMs{ 0.0 };
+		double m_LatchSavedMaxMs{ 0.0 };
+
+		//timings of the recording thread, split by the phases of draw()
+		FrameStats m_FrameStats;
+		uint32_t m_StatFrame, m_StatWait, m_StatAcquire, m_StatReset, m_StatRecord, m_StatSubmit, m_StatPresent;
+		//time the recording thread actually worked, the frame minus the waits for the GPU and the swapchain
+		uint32_t m_StatBusy;
+
+		//GPU scopes, reported through m_FrameStats one trip through the frame ring late
+		GpuProfiler m_GpuProfiler;
+		uint32_t m_GpuScopeFrame, m_GpuScopeMainPass;
+		std::string m_StatsCsvPath;
+		std::string m_StatsJsonPath;
+		//set when the window changed size, the swapchain is rebuilt before the next acquire
+		bool m_SwapchainDirty{ false };
+		//resize count of the last snapshot the renderer looked at
+		uint32_t m_SeenResizeCount{ 0 };
+		uint64_t m_MaxFrames{ 0 };
+		uint64_t m_FrameNumber{ 0 };
+
+		//owned by the main thread, copied into a snapshot for every frame
+		FrameSnapshot m_GameState;
+		//hands snapshots from the main thread to the render thread in threaded mode
+		TripleBuffer<FrameSnapshot> m_Snapshots;
+		std::thread m_RenderThread;
+		std::atomic<bool> m_QuitRequested{ false };
+
+		//frames waiting for the present thread, in submission order
+		std::deque<PresentRequest> m_PresentRequests;
+		std::mutex m_PresentMutex;
+		std::condition_variable m_PresentCondition;
+		bool m_PresentStop{ false };
+		std::thread m_PresentThread;
+
+		VkPresentModeKHR m_PresentMode{ VK_PRESENT_MODE_FIFO_KHR };
+		FrameLimiter m_FrameLimiter;
 
 
 		VkInstance m_Instance;
@@ -78,57 +292,80 @@ namespace vkEngine {
 		VkQueue m_GraphicsQueue;
 		uint32_t m_GraphicsQueueFamily;
 
-		VkCommandPool m_CommandPool;
-		VkCommandBuffer m_MainCommandBuffer;
+		//every submission to the graphics queue signals the next value on this timeline
+		TimelineSemaphore m_GraphicsTimeline;
+		//signaled by the present thread's copies, one value per frame, so frame N's copy signals N + 1
+		TimelineSemaphore m_PresentTimeline;
+		//the recording and present threads share the graphics queue
+		std::mutex m_QueueMutex;
+
+		VmaAllocator m_Allocator;
+
+		FrameData m_Frames[MAX_FRAMES_IN_FLIGHT];
+		uint32_t m_FramesInFlight{ 2 };
 
 		VkRenderPass m_RenderPass;
 		std::vector<VkFramebuffer> m_Framebuffers;
 
 		
+		VkDescriptorSetLayout m_FrameSetLayout;
+		VkDescriptorPool m_DescriptorPool;
+
+		//reflected from the triangle shaders, owned by m_LayoutCache
 		VkPipelineLayout m_TrianglePipelineLayout;
 
-		VkPipeline m_TrianglePipeline;
-		VkPipeline m_SpecialTrianglePipeline;
-		VkSemaphore m_PresentSemaphore, m_RenderSemaphore;
-		VkFence m_RenderFence;
+		//every graphics pipeline, deduplicated by state
+		PipelineRegistry m_PipelineRegistry;
+		//triangle pipeline per FrameSnapshot::m_ShaderIndex, one set of shaders specialized per variant and compiled in the background
+		PipelinePermutations m_TrianglePermutations;
 
-		VkDebugUtilsMessengerEXT m_DebugMessanger;
+		//recompiles changed shaders with --hot-reload
+		ShaderWatcher m_ShaderWatcher;
+		struct ReloadedPipeline
+		{
+			PipelineId m_Id;
+			VkPipeline m_Pipeline;
+		};
+		//rebuilt pipelines waiting for the next frame boundary, the flag spares draw() the lock
+		std::mutex m_ReloadMutex;
+		std::vector<ReloadedPipeline> m_ReloadedPipelines;
+		std::atomic<bool> m_HasReloadedPipelines{ false };
+
+		PipelineCache m_PipelineCache;
+		std::string m_PipelineCachePath;
+		//time init_pipeline spent compiling, for the startup report
+		double m_PipelineBuildMs{ 0.0 };
+
+		VkDebugUtilsMessengerEXT m_DebugMessanger{ VK_NULL_HANDLE };
+
+		//workers for init and any other work that can leave the main thread
+		JobSystem m_JobSystem;
+		//every shader module, shared by content
+		ShaderCache m_ShaderCache;
+		//descriptor set and pipeline layouts, shared by content
+		LayoutCache m_LayoutCache;
 
 		DeletionQueue m_MainDeletionQueue;
+		//objects released while running, collected every frame as the graphics timeline advances
+		DeferredDeletionQueue m_FrameDeletionQueue;
+		//swapchains retired by the present thread, collected as the present timeline advances
+		DeferredDeletionQueue m_PresentDeletionQueue;
 	private:
 		VkSwapchainKHR m_Swapchain; 
-		//image format expected by the windowing system
+		//format and color space the swapchain is created with
+		VkSurfaceFormatKHR m_SurfaceFormat;
+		//format of the images the main pass renders into, the swapchain's own unless we render offscreen
 		VkFormat m_SwapchainImageFormat;
 		//array of images from the swapchain
 		std::vector<VkImage> m_SwapchainImages;
 		//array of image-views from the swapchain
 		std::vector<VkImageView> m_SwapchainImageViews;
+		//render targets backing m_SwapchainImages when running headless or with the present thread
+		std::vector<AllocatedImage> m_OffscreenImages;
+		//the window's swapchain images when the present thread owns the swapchain, only ever blitted into
+		std::vector<VkImage> m_PresentImages;
+		VkExtent2D m_PresentExtent;
 
 	};
 
-
-	class PipelineBuilder 
-	{
-
-
-
-	public: 
-		std::vector<VkPipelineShaderStageCreateInfo> m_ShaderStages;
-		VkPipelineVertexInputStateCreateInfo m_VertexInputInfo;
-		VkPipelineInputAssemblyStateCreateInfo m_InputAssembly;
-		VkViewport m_Viewport;
-		VkRect2D m_Scissor;
-		VkPipelineRasterizationStateCreateInfo m_Rasterizer;
-		VkPipelineColorBlendAttachmentState m_ColorBlendAttachment;
-		VkPipelineMultisampleStateCreateInfo m_Multisampling;
-		VkPipelineLayout m_PipelineLayout;
-	public:
-		VkPipeline build_pipeline(VkDevice device, VkRenderPass pass);
-
-
-
-
-	};
-
-
 }
@@ -0,0 +1,96 @@
+#include <vkFrameLimiter.h>
+
+#include <iostream>
+#include <thread>
+
+//OS sleeps can overshoot by a scheduler tick, so the last stretch before the deadline is spun instead
+constexpr std::chrono::microseconds SPIN_THRESHOLD{ 2000 };
+
+void vkEngine::FrameLimiter::set_target_frame_time(double milliseconds)
+{
+	m_TargetFrameTimeMs = milliseconds > 0.0 ? milliseconds : 0.0;
+	m_HasDeadline = false;
+}
+
+void vkEngine::FrameLimiter::wait_for_next_frame()
+{
+	if (m_TargetFrameTimeMs <= 0.0)
+		return;
+
+	auto frameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(m_TargetFrameTimeMs));
+	Clock::time_point now = Clock::now();
+
+	if (!m_HasDeadline)
+	{
+		m_NextFrameDeadline = now;
+		m_HasDeadline = true;
+	}
+
+	if (now < m_NextFrameDeadline)
+	{
+		if (m_NextFrameDeadline - now > SPIN_THRESHOLD)
+			std::this_thread::sleep_until(m_NextFrameDeadline - SPIN_THRESHOLD);
+
+		while (Clock::now() < m_NextFrameDeadline)
+			std::this_thread::yield();
+	}
+
+	//advance from the deadline rather than from now so small oversleeps do not accumulate,
+	//but resync after a long stall instead of rendering a burst of frames to catch up
+	m_NextFrameDeadline += frameTime;
+	if (m_NextFrameDeadline < Clock::now())
+		m_NextFrameDeadline = Clock::now() + frameTime;
+}
+
+void vkEngine::FrameLimiter::mark_input()
+{
+	mark_input(Clock::now());
+}
+
+void vkEngine::FrameLimiter::mark_input(Clock::time_point inputTime)
+{
+	m_InputTime = inputTime;
+	m_HasPendingInput = true;
+}
+
+void vkEngine::FrameLimiter::mark_presented()
+{
+	if (!m_HasPendingInput)
+		return;
+
+	m_HasPendingInput = false;
+	mark_presented(m_InputTime);
+}
+
+void vkEngine::FrameLimiter::mark_presented(Clock::time_point inputTime)
+{
+	double latency = std::chrono::duration<double, std::milli>(Clock::now() - inputTime).count();
+
+	if (m_LatencySamples == 0)
+	{
+		m_LatencyMinMs = latency;
+		m_LatencyMaxMs = latency;
+	}
+	else
+	{
+		m_LatencyMinMs = latency < m_LatencyMinMs ? latency : m_LatencyMinMs;
+		m_LatencyMaxMs = latency > m_LatencyMaxMs ? latency : m_LatencyMaxMs;
+	}
+
+	m_LatencySumMs += latency;
+	m_LatencySamples++;
+}
+
+void vkEngine::FrameLimiter::report() const
+{
+	if (m_TargetFrameTimeMs > 0.0)
+		std::cout << "Frame limiter target: " << m_TargetFrameTimeMs << " ms" << std::endl;
+	else
+		std::cout << "Frame limiter disabled" << std::endl;
+
+	if (m_LatencySamples == 0)
+		return;
+
+	std::cout << "Input to present latency: avg " << m_LatencySumMs / m_LatencySamples
+		<< " ms, min " << m_LatencyMinMs << " ms, max " << m_LatencyMaxMs << " ms over " << m_LatencySamples << " frames" << std::endl;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace vkEngine {
+
+	//paces the main loop to a target frame time and measures how old the input is by the time its frame is presented
+	class FrameLimiter
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		//0 disables pacing, latency is still measured
+		void set_target_frame_time(double milliseconds);
+		double get_target_frame_time() const { return m_TargetFrameTimeMs; }
+
+		//blocks until the next frame is due, call before sampling input so the input is as fresh as possible
+		void wait_for_next_frame();
+
+		//input for the next frame has been sampled
+		void mark_input();
+		//same, for input sampled earlier on another thread
+		void mark_input(Clock::time_point inputTime);
+		//the frame built from the last sampled input has been handed to the presentation engine
+		void mark_presented();
+		//same, for a frame presented on another thread, only touches the latency statistics
+		void mark_presented(Clock::time_point inputTime);
+
+		//prints the averaged input-to-present latency
+		void report() const;
+
+	private:
+		double m_TargetFrameTimeMs{ 0.0 };
+		Clock::time_point m_NextFrameDeadline{};
+		bool m_HasDeadline{ false };
+
+		Clock::time_point m_InputTime{};
+		bool m_HasPendingInput{ false };
+
+		uint64_t m_LatencySamples{ 0 };
+		double m_LatencySumMs{ 0.0 };
+		double m_LatencyMinMs{ 0.0 };
+		double m_LatencyMaxMs{ 0.0 };
+	};
+
+}
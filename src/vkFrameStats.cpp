@@ -0,0 +1,218 @@
+#include <vkFrameStats.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+//what a late timer's row holds until its result comes in
+static const double NO_SAMPLE = std::nan("");
+
+uint32_t vkEngine::FrameStats::register_timer(const char* name, bool late)
+{
+	if (m_TimerCount == MAX_TIMERS)
+	{
+		std::cout << "Frame stats are full, not tracking " << name << std::endl;
+		return UINT32_MAX;
+	}
+
+	m_TimerNames[m_TimerCount] = name;
+	if (late)
+		m_LateTimers |= 1u << m_TimerCount;
+	return m_TimerCount++;
+}
+
+void vkEngine::FrameStats::begin_frame(uint64_t frameNumber)
+{
+	m_CurrentFrame = frameNumber;
+	std::fill(std::begin(m_Current), std::end(m_Current), 0.0);
+	for (uint32_t t = 0; t < m_TimerCount; t++)
+	{
+		if (m_LateTimers & (1u << t))
+			m_Current[t] = NO_SAMPLE;
+	}
+}
+
+void vkEngine::FrameStats::end_frame()
+{
+	uint32_t row = (uint32_t)(m_Committed % HISTORY_SIZE);
+	std::copy(std::begin(m_Current), std::end(m_Current), m_Rows[row]);
+	m_FrameNumbers[row] = m_CurrentFrame;
+	m_Committed++;
+}
+
+void vkEngine::FrameStats::record(uint32_t timer, double milliseconds)
+{
+	if (timer < m_TimerCount)
+		m_Current[timer] += milliseconds;
+}
+
+void vkEngine::FrameStats::record_committed(uint64_t frameNumber, uint32_t timer, double milliseconds)
+{
+	if (timer >= m_TimerCount)
+		return;
+
+	//frame numbers only grow, so the search ends at the first older frame
+	for (uint32_t i = get_frame_count(); i > 0; i--)
+	{
+		uint32_t row = row_index(i - 1);
+		if (m_FrameNumbers[row] < frameNumber)
+			return;
+		if (m_FrameNumbers[row] == frameNumber)
+		{
+			double& value = m_Rows[row][timer];
+			value = std::isnan(value) ? milliseconds : value + milliseconds;
+			return;
+		}
+	}
+}
+
+vkEngine::FrameStats::Clock::time_point vkEngine::FrameStats::lap(uint32_t timer, Clock::time_point start)
+{
+	Clock::time_point now = Clock::now();
+	record(timer, std::chrono::duration<double, std::milli>(now - start).count());
+	return now;
+}
+
+uint32_t vkEngine::FrameStats::get_frame_count() const
+{
+	return (uint32_t)std::min<uint64_t>(m_Committed, HISTORY_SIZE);
+}
+
+uint32_t vkEngine::FrameStats::row_index(uint32_t i) const
+{
+	uint64_t oldest = m_Committed - get_frame_count();
+	return (uint32_t)((oldest + i) % HISTORY_SIZE);
+}
+
+vkEngine::FrameStats::Percentiles vkEngine::FrameStats::get_percentiles(uint32_t timer) const
+{
+	Percentiles result;
+	uint32_t count = get_frame_count();
+	if (count == 0 || timer >= m_TimerCount)
+		return result;
+
+	std::array<double, HISTORY_SIZE> samples;
+	uint32_t frameCount = count;
+	count = 0;
+	double sum = 0.0;
+	for (uint32_t i = 0; i < frameCount; i++)
+	{
+		double value = m_Rows[i][timer];
+		if (std::isnan(value))
+			continue;
+		samples[count++] = value;
+		sum += value;
+	}
+	result.m_SampleCount = count;
+	if (count == 0)
+		return result;
+	result.m_Average = sum / count;
+
+	//nearest rank, each selection only partially orders the samples
+	auto select = [&](double percentile) {
+		uint32_t rank = std::min(count - 1, (uint32_t)(percentile * count));
+		std::nth_element(samples.begin(), samples.begin() + rank, samples.begin() + count);
+		return samples[rank];
+	};
+
+	result.m_P50 = select(0.50);
+	result.m_P95 = select(0.95);
+	result.m_P99 = select(0.99);
+	return result;
+}
+
+void vkEngine::FrameStats::report() const
+{
+	uint32_t count = get_frame_count();
+	if (count == 0)
+		return;
+
+	std::cout << "Frame timings over the last " << count << " frames (ms):" << std::endl;
+	for (uint32_t t = 0; t < m_TimerCount; t++)
+	{
+		Percentiles p = get_percentiles(t);
+		if (p.m_SampleCount == 0)
+		{
+			std::cout << "  " << m_TimerNames[t] << ": no samples" << std::endl;
+			continue;
+		}
+		std::cout << "  " << m_TimerNames[t] << ": avg " << p.m_Average << ", p50 " << p.m_P50
+			<< ", p95 " << p.m_P95 << ", p99 " << p.m_P99;
+		if (p.m_SampleCount < count)
+			std::cout << " (" << p.m_SampleCount << " samples)";
+		std::cout << std::endl;
+	}
+}
+
+bool vkEngine::FrameStats::write_csv(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write frame stats to " << path << std::endl;
+		return false;
+	}
+
+	file << "frame";
+	for (uint32_t t = 0; t < m_TimerCount; t++)
+		file << "," << m_TimerNames[t];
+	file << "\n";
+
+	for (uint32_t i = 0; i < get_frame_count(); i++)
+	{
+		uint32_t row = row_index(i);
+		file << m_FrameNumbers[row];
+		//frames without a sample leave the field empty
+		for (uint32_t t = 0; t < m_TimerCount; t++)
+		{
+			file << ",";
+			if (!std::isnan(m_Rows[row][t]))
+				file << m_Rows[row][t];
+		}
+		file << "\n";
+	}
+
+	std::cout << "Frame stats written to " << path << std::endl;
+	return true;
+}
+
+bool vkEngine::FrameStats::write_json(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write frame stats to " << path << std::endl;
+		return false;
+	}
+
+	//timer names are identifiers chosen by the engine, nothing in them needs escaping
+	file << "{\n  \"timers\": [\n";
+	for (uint32_t t = 0; t < m_TimerCount; t++)
+	{
+		Percentiles p = get_percentiles(t);
+		file << "    { \"name\": \"" << m_TimerNames[t] << "\", \"avg\": " << p.m_Average << ", \"p50\": " << p.m_P50
+			<< ", \"p95\": " << p.m_P95 << ", \"p99\": " << p.m_P99 << " }" << (t + 1 < m_TimerCount ? "," : "") << "\n";
+	}
+	file << "  ],\n  \"frames\": [\n";
+
+	uint32_t count = get_frame_count();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t row = row_index(i);
+		file << "    [" << m_FrameNumbers[row];
+		for (uint32_t t = 0; t < m_TimerCount; t++)
+		{
+			if (std::isnan(m_Rows[row][t]))
+				file << ", null";
+			else
+				file << ", " << m_Rows[row][t];
+		}
+		file << "]" << (i + 1 < count ? "," : "") << "\n";
+	}
+	file << "  ]\n}\n";
+
+	std::cout << "Frame stats written to " << path << std::endl;
+	return true;
+}
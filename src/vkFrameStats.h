@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace vkEngine {
+
+	//per-frame timings of named phases, kept in a fixed ring so recording never allocates.
+	//CPU phases and GPU scopes register timers here alike, percentiles are computed over the frames in the ring
+	class FrameStats
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr uint32_t MAX_TIMERS = 16;
+		static constexpr uint32_t HISTORY_SIZE = 1024;
+
+		struct Percentiles
+		{
+			double m_P50{ 0.0 };
+			double m_P95{ 0.0 };
+			double m_P99{ 0.0 };
+			double m_Average{ 0.0 };
+			//frames that had a sample, late timers miss the frames whose results never came back
+			uint32_t m_SampleCount{ 0 };
+		};
+
+		//returns the index used to record the timer, or UINT32_MAX once MAX_TIMERS are taken. names must outlive the stats.
+		//late timers are only known after their frame was committed, like GPU scopes, and are filled in with record_committed.
+		//their rows hold no sample until then and are left out of the percentiles
+		uint32_t register_timer(const char* name, bool late = false);
+		uint32_t get_timer_count() const { return m_TimerCount; }
+		const char* get_timer_name(uint32_t timer) const { return m_TimerNames[timer]; }
+
+		//starts a new row, every timer reads 0 until it is recorded, late timers read as having no sample
+		void begin_frame(uint64_t frameNumber);
+		//commits the current row to the ring, a frame that is never ended leaves no trace
+		void end_frame();
+
+		void record(uint32_t timer, double milliseconds);
+		//adds to the row of an already committed frame, dropped if that frame is no longer in the ring
+		void record_committed(uint64_t frameNumber, uint32_t timer, double milliseconds);
+		//what the current row holds for the timer so far
+		double get_current(uint32_t timer) const { return timer < m_TimerCount ? m_Current[timer] : 0.0; }
+
+		//adds the time since start to the timer and returns now, so consecutive phases can be chained
+		Clock::time_point lap(uint32_t timer, Clock::time_point start);
+
+		//rolling statistics over the committed frames still in the ring
+		Percentiles get_percentiles(uint32_t timer) const;
+		uint32_t get_frame_count() const;
+
+		void report() const;
+
+		//one row per frame in the ring, oldest first. Returns false if the file can't be written
+		bool write_csv(const std::string& path) const;
+		//percentiles per timer plus the raw rows
+		bool write_json(const std::string& path) const;
+
+	private:
+		//ring position of the i-th oldest committed frame
+		uint32_t row_index(uint32_t i) const;
+
+		const char* m_TimerNames[MAX_TIMERS];
+		uint32_t m_TimerCount{ 0 };
+		//one bit per timer registered as late
+		uint32_t m_LateTimers{ 0 };
+
+		double m_Rows[HISTORY_SIZE][MAX_TIMERS];
+		uint64_t m_FrameNumbers[HISTORY_SIZE];
+
+		double m_Current[MAX_TIMERS];
+		uint64_t m_CurrentFrame{ 0 };
+
+		//total frames committed, the ring holds the last HISTORY_SIZE of them
+		uint64_t m_Committed{ 0 };
+	};
+
+}
@@ -0,0 +1,125 @@
+#include <vkGpuProfiler.h>
+
+#include <iostream>
+
+void vkEngine::GpuProfiler::init(VkDevice device, VkPhysicalDevice gpu, uint32_t queueFamily, uint32_t slotCount)
+{
+	m_Device = device;
+
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(gpu, &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(gpu, &familyCount, families.data());
+
+	uint32_t validBits = queueFamily < familyCount ? families[queueFamily].timestampValidBits : 0;
+	if (validBits == 0)
+	{
+		std::cout << "The graphics queue does not support timestamps, GPU timings are disabled" << std::endl;
+		return;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(gpu, &properties);
+	m_TimestampPeriod = properties.limits.timestampPeriod;
+	m_TimestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+	VkQueryPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.pNext = nullptr;
+
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = MAX_SCOPES * 2;
+
+	m_Slots.resize(slotCount);
+	for (Slot& slot : m_Slots)
+	{
+		//profiling is optional, so a failure turns it off instead of taking the engine down
+		if (vkCreateQueryPool(m_Device, &poolInfo, nullptr, &slot.m_Pool) != VK_SUCCESS)
+		{
+			std::cout << "Failed to create a timestamp query pool, GPU timings are disabled" << std::endl;
+			destroy();
+			return;
+		}
+	}
+
+	m_Enabled = true;
+}
+
+void vkEngine::GpuProfiler::destroy()
+{
+	for (Slot& slot : m_Slots)
+	{
+		vkDestroyQueryPool(m_Device, slot.m_Pool, nullptr);
+	}
+	m_Slots.clear();
+	m_Enabled = false;
+}
+
+uint32_t vkEngine::GpuProfiler::register_scope(const char* timerName, FrameStats& stats)
+{
+	if (!m_Enabled)
+		return UINT32_MAX;
+
+	if (m_ScopeCount == MAX_SCOPES)
+	{
+		std::cout << "Too many GPU scopes, not tracking " << timerName << std::endl;
+		return UINT32_MAX;
+	}
+
+	m_ScopeTimers[m_ScopeCount] = stats.register_timer(timerName, true);
+	return m_ScopeCount++;
+}
+
+void vkEngine::GpuProfiler::begin_frame(VkCommandBuffer cmd, uint32_t slot, uint64_t frameNumber, FrameStats& stats)
+{
+	if (!m_Enabled)
+		return;
+
+	m_CurrentSlot = slot;
+	Slot& current = m_Slots[slot];
+
+	if (current.m_WrittenScopes != 0)
+	{
+		uint64_t timestamps[MAX_SCOPES * 2];
+
+		//the caller waited for this slot's last frame, so no wait flag. Anything still unavailable is simply skipped
+		VkResult result = vkGetQueryPoolResults(m_Device, current.m_Pool, 0, m_ScopeCount * 2, sizeof(timestamps), timestamps,
+			sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+		if (result == VK_SUCCESS)
+		{
+			for (uint32_t scope = 0; scope < m_ScopeCount; scope++)
+			{
+				if ((current.m_WrittenScopes & (1u << scope)) == 0)
+					continue;
+
+				uint64_t ticks = (timestamps[scope * 2 + 1] - timestamps[scope * 2]) & m_TimestampMask;
+				stats.record_committed(current.m_FrameNumber, m_ScopeTimers[scope], ticks * m_TimestampPeriod / 1000000.0);
+			}
+		}
+	}
+
+	vkCmdResetQueryPool(cmd, current.m_Pool, 0, MAX_SCOPES * 2);
+	current.m_WrittenScopes = 0;
+	current.m_FrameNumber = frameNumber;
+	m_OpenScopes = 0;
+}
+
+void vkEngine::GpuProfiler::begin_scope(VkCommandBuffer cmd, uint32_t scope)
+{
+	if (!m_Enabled || scope >= m_ScopeCount)
+		return;
+
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_Slots[m_CurrentSlot].m_Pool, scope * 2);
+	m_OpenScopes |= 1u << scope;
+}
+
+void vkEngine::GpuProfiler::end_scope(VkCommandBuffer cmd, uint32_t scope)
+{
+	if (!m_Enabled || scope >= m_ScopeCount || (m_OpenScopes & (1u << scope)) == 0)
+		return;
+
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_Slots[m_CurrentSlot].m_Pool, scope * 2 + 1);
+	m_OpenScopes &= ~(1u << scope);
+	m_Slots[m_CurrentSlot].m_WrittenScopes |= 1u << scope;
+}
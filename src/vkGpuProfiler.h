@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vkTypes.h>
+#include <vkFrameStats.h>
+#include <vector>
+
+namespace vkEngine {
+
+	//named GPU scopes measured with timestamp queries, one query pool per frame slot.
+	//a slot's results are read back when the slot comes around again, after its timeline wait,
+	//so reading them never stalls. durations show up in FrameStats as late gpu.<name> timers,
+	//in the row of the frame that recorded them
+	class GpuProfiler
+	{
+	public:
+		static constexpr uint32_t MAX_SCOPES = 8;
+
+		//disables itself if the graphics queue does not support timestamps
+		void init(VkDevice device, VkPhysicalDevice gpu, uint32_t queueFamily, uint32_t slotCount);
+		void destroy();
+
+		bool is_enabled() const { return m_Enabled; }
+
+		//registers the scope's timer in stats. Returns the index to pass to begin_scope/end_scope,
+		//or UINT32_MAX when profiling is disabled, which the scope functions ignore
+		uint32_t register_scope(const char* timerName, FrameStats& stats);
+		//the FrameStats timer of a scope, UINT32_MAX for scopes that are not tracked
+		uint32_t get_timer(uint32_t scope) const { return scope < m_ScopeCount ? m_ScopeTimers[scope] : UINT32_MAX; }
+
+		//reads the results the slot collected last time into the stats row of the frame that recorded them,
+		//then resets its queries for frameNumber. must be recorded before any scope of the frame and outside of a render pass
+		void begin_frame(VkCommandBuffer cmd, uint32_t slot, uint64_t frameNumber, FrameStats& stats);
+
+		void begin_scope(VkCommandBuffer cmd, uint32_t scope);
+		void end_scope(VkCommandBuffer cmd, uint32_t scope);
+
+	private:
+		struct Slot
+		{
+			VkQueryPool m_Pool{ VK_NULL_HANDLE };
+			//scopes with both timestamps written in the last frame recorded into this slot
+			uint32_t m_WrittenScopes{ 0 };
+			//the frame those timestamps belong to
+			uint64_t m_FrameNumber{ 0 };
+		};
+
+		VkDevice m_Device{ VK_NULL_HANDLE };
+		bool m_Enabled{ false };
+		//nanoseconds per timestamp tick
+		double m_TimestampPeriod{ 1.0 };
+		uint64_t m_TimestampMask{ ~0ull };
+
+		std::vector<Slot> m_Slots;
+		uint32_t m_CurrentSlot{ 0 };
+
+		uint32_t m_ScopeTimers[MAX_SCOPES];
+		uint32_t m_ScopeCount{ 0 };
+		uint32_t m_OpenScopes{ 0 };
+	};
+
+}
@@ -0,0 +1,147 @@
+#include <vkInitGraph.h>
+
+#include <algorithm>
+#include <iostream>
+
+uint32_t vkEngine::InitGraph::add_step(const char* name, StepFunction&& function, std::initializer_list<uint32_t> dependencies)
+{
+	return add(name, std::move(function), dependencies, false);
+}
+
+uint32_t vkEngine::InitGraph::add_main_thread_step(const char* name, StepFunction&& function, std::initializer_list<uint32_t> dependencies)
+{
+	return add(name, std::move(function), dependencies, true);
+}
+
+uint32_t vkEngine::InitGraph::add(const char* name, StepFunction&& function, std::initializer_list<uint32_t> dependencies, bool mainThread)
+{
+	uint32_t index = (uint32_t)m_Steps.size();
+
+	m_Steps.emplace_back();
+	Step& step = m_Steps.back();
+	step.m_Name = name;
+	step.m_Function = std::move(function);
+	step.m_MainThread = mainThread;
+
+	for (uint32_t dependency : dependencies)
+	{
+		if (dependency >= index)
+		{
+			std::cout << "Init step " << name << " depends on a step that was not added before it" << std::endl;
+			abort();
+		}
+		step.m_Dependencies.push_back(dependency);
+		m_Steps[dependency].m_Dependents.push_back(index);
+	}
+
+	return index;
+}
+
+void vkEngine::InitGraph::run(JobSystem& jobs)
+{
+	m_Start = Clock::now();
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_FinishedCount = 0;
+
+	for (uint32_t i = 0; i < m_Steps.size(); i++)
+		m_Steps[i].m_PendingDependencies = (uint32_t)m_Steps[i].m_Dependencies.size();
+
+	for (uint32_t i = 0; i < m_Steps.size(); i++)
+	{
+		if (m_Steps[i].m_PendingDependencies == 0)
+			schedule(i, jobs);
+	}
+
+	//the calling thread runs the main thread steps as they become ready, and every step when there are no workers
+	while (true)
+	{
+		m_Condition.wait(lock, [this]() { return !m_MainThreadSteps.empty() || m_FinishedCount == m_Steps.size(); });
+		if (m_MainThreadSteps.empty())
+			break;
+
+		uint32_t step = m_MainThreadSteps.front();
+		m_MainThreadSteps.pop_front();
+
+		lock.unlock();
+		execute(step, false);
+		complete(step, jobs);
+		lock.lock();
+	}
+
+	m_WallMs = std::chrono::duration<double, std::milli>(Clock::now() - m_Start).count();
+}
+
+void vkEngine::InitGraph::schedule(uint32_t step, JobSystem& jobs)
+{
+	if (m_Steps[step].m_MainThread || jobs.worker_count() == 0)
+	{
+		m_MainThreadSteps.push_back(step);
+		m_Condition.notify_all();
+		return;
+	}
+
+	jobs.submit([this, step, &jobs]() {
+		execute(step, true);
+		complete(step, jobs);
+	});
+}
+
+void vkEngine::InitGraph::execute(uint32_t step, bool onWorker)
+{
+	Step& current = m_Steps[step];
+
+	Clock::time_point start = Clock::now();
+	current.m_Function(current.m_Deletions);
+	Clock::time_point end = Clock::now();
+
+	current.m_StartMs = std::chrono::duration<double, std::milli>(start - m_Start).count();
+	current.m_DurationMs = std::chrono::duration<double, std::milli>(end - start).count();
+	current.m_RanOnWorker = onWorker;
+}
+
+void vkEngine::InitGraph::complete(uint32_t step, JobSystem& jobs)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	for (uint32_t dependent : m_Steps[step].m_Dependents)
+	{
+		if (--m_Steps[dependent].m_PendingDependencies == 0)
+			schedule(dependent, jobs);
+	}
+
+	m_FinishedCount++;
+	m_Condition.notify_all();
+}
+
+void vkEngine::InitGraph::append_deletions(DeletionQueue& queue)
+{
+	for (Step& step : m_Steps)
+		queue.append(std::move(step.m_Deletions));
+}
+
+void vkEngine::InitGraph::report() const
+{
+	//longest chain of dependent steps, nothing can start up faster than that with this graph
+	std::vector<double> pathEndMs(m_Steps.size(), 0.0);
+	double criticalPathMs = 0.0;
+	double stepSumMs = 0.0;
+	for (size_t i = 0; i < m_Steps.size(); i++)
+	{
+		double dependencyEndMs = 0.0;
+		for (uint32_t dependency : m_Steps[i].m_Dependencies)
+			dependencyEndMs = std::max(dependencyEndMs, pathEndMs[dependency]);
+
+		pathEndMs[i] = dependencyEndMs + m_Steps[i].m_DurationMs;
+		criticalPathMs = std::max(criticalPathMs, pathEndMs[i]);
+		stepSumMs += m_Steps[i].m_DurationMs;
+	}
+
+	std::cout << "Startup breakdown (ms):" << std::endl;
+	for (const Step& step : m_Steps)
+	{
+		std::cout << "  " << step.m_Name << ": start " << step.m_StartMs << ", took " << step.m_DurationMs
+			<< (step.m_RanOnWorker ? " on a worker" : " on the main thread") << std::endl;
+	}
+	std::cout << "  " << m_WallMs << " wall for " << stepSumMs << " of steps, critical path " << criticalPathMs << std::endl;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vkDeletionQueue.h>
+#include <vkJobSystem.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <vector>
+
+namespace vkEngine {
+
+	//initialization steps and the steps they depend on. independent steps run concurrently on the job system's workers.
+	//each step registers its cleanup in a queue of its own, so the destruction order does not depend on scheduling
+	class InitGraph
+	{
+	public:
+		using StepFunction = std::function<void(DeletionQueue&)>;
+
+		//dependencies are indices returned by earlier calls, which keeps the graph acyclic. Returns the step's index
+		uint32_t add_step(const char* name, StepFunction&& function, std::initializer_list<uint32_t> dependencies = {});
+
+		//for steps that have to stay on the thread calling run(), like creating the SDL window
+		uint32_t add_main_thread_step(const char* name, StepFunction&& function, std::initializer_list<uint32_t> dependencies = {});
+
+		//runs every step and returns once all of them finished. without workers the steps run one after another in order
+		void run(JobSystem& jobs);
+
+		//moves the steps' cleanup into the queue in the order the steps were added, so later steps are destroyed first
+		void append_deletions(DeletionQueue& queue);
+
+		//prints the start and duration of every step, the critical path and the total wall time
+		void report() const;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Step
+		{
+			const char* m_Name;
+			StepFunction m_Function;
+			bool m_MainThread;
+			std::vector<uint32_t> m_Dependencies;
+			std::vector<uint32_t> m_Dependents;
+			uint32_t m_PendingDependencies;
+			DeletionQueue m_Deletions;
+
+			//relative to the start of run()
+			double m_StartMs{ 0.0 };
+			double m_DurationMs{ 0.0 };
+			bool m_RanOnWorker{ false };
+		};
+
+		uint32_t add(const char* name, StepFunction&& function, std::initializer_list<uint32_t> dependencies, bool mainThread);
+
+		//hands a step whose dependencies finished to a worker, or to the thread in run(). m_Mutex must be held
+		void schedule(uint32_t step, JobSystem& jobs);
+
+		void execute(uint32_t step, bool onWorker);
+
+		//releases the step's dependents
+		void complete(uint32_t step, JobSystem& jobs);
+
+		std::vector<Step> m_Steps;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		std::deque<uint32_t> m_MainThreadSteps;
+		uint32_t m_FinishedCount{ 0 };
+
+		Clock::time_point m_Start;
+		double m_WallMs{ 0.0 };
+	};
+
+}
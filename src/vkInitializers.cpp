@@ -26,7 +26,7 @@ namespace vkInit
 		return info;
 	}
 
-	VkPipelineShaderStageCreateInfo vkInit::pipeline_shader_stage_create_info(VkShaderStageFlagBits stage, VkShaderModule shaderModule)
+	VkPipelineShaderStageCreateInfo pipeline_shader_stage_create_info(VkShaderStageFlagBits stage, VkShaderModule shaderModule)
 	{
 
 		VkPipelineShaderStageCreateInfo info{};
@@ -44,7 +44,7 @@ namespace vkInit
 	}
 
 
-	VkPipelineVertexInputStateCreateInfo vkInit::vertex_input_state_create_info() 
+	VkPipelineVertexInputStateCreateInfo vertex_input_state_create_info() 
 	{
 		VkPipelineVertexInputStateCreateInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -58,7 +58,7 @@ namespace vkInit
 
 
 
-	VkPipelineInputAssemblyStateCreateInfo vkInit::input_assembly_create_info(VkPrimitiveTopology topology) 
+	VkPipelineInputAssemblyStateCreateInfo input_assembly_create_info(VkPrimitiveTopology topology) 
 	{
 
 		VkPipelineInputAssemblyStateCreateInfo info = {};
@@ -71,7 +71,7 @@ namespace vkInit
 		return info;
 	}
 
-	VkPipelineRasterizationStateCreateInfo vkInit::rasterization_state_create_info(VkPolygonMode polygonMode)
+	VkPipelineRasterizationStateCreateInfo rasterization_state_create_info(VkPolygonMode polygonMode)
 	{
 		VkPipelineRasterizationStateCreateInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -95,7 +95,7 @@ namespace vkInit
 		return info;
 	}
 
-	VkPipelineMultisampleStateCreateInfo vkInit::multisampling_state_create_info()
+	VkPipelineMultisampleStateCreateInfo multisampling_state_create_info()
 	{
 		VkPipelineMultisampleStateCreateInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
@@ -111,7 +111,7 @@ namespace vkInit
 		return info;
 	}
 
-	VkPipelineColorBlendAttachmentState vkInit::color_blend_attachment_state() 
+	VkPipelineColorBlendAttachmentState color_blend_attachment_state() 
 	{
 		VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
 		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
@@ -120,7 +120,7 @@ namespace vkInit
 		return colorBlendAttachment;
 	}
 
-	VkPipelineLayoutCreateInfo vkInit::pipeline_layout_create_info() 
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info() 
 	{
 		VkPipelineLayoutCreateInfo info{};
 		info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -136,7 +136,7 @@ namespace vkInit
 	}
 
 
-	VkFenceCreateInfo vkInit::fence_create_info(VkFenceCreateFlags flags)
+	VkFenceCreateInfo fence_create_info(VkFenceCreateFlags flags)
 	{
 		VkFenceCreateInfo fenceCreateInfo = {};
 		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
@@ -145,7 +145,7 @@ namespace vkInit
 		return fenceCreateInfo;
 	}
 
-	VkSemaphoreCreateInfo vkInit::semaphore_create_info(VkSemaphoreCreateFlags flags)
+	VkSemaphoreCreateInfo semaphore_create_info(VkSemaphoreCreateFlags flags)
 	{
 		VkSemaphoreCreateInfo semCreateInfo = {};
 		semCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -154,4 +154,107 @@ namespace vkInit
 		return semCreateInfo;
 	}
 
+	VkImageCreateInfo image_create_info(VkFormat format, VkImageUsageFlags usageFlags, VkExtent3D extent)
+	{
+		VkImageCreateInfo info = { };
+		info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		info.pNext = nullptr;
+
+		info.imageType = VK_IMAGE_TYPE_2D;
+
+		info.format = format;
+		info.extent = extent;
+
+		//single mip, single layer and no MSAA
+		info.mipLevels = 1;
+		info.arrayLayers = 1;
+		info.samples = VK_SAMPLE_COUNT_1_BIT;
+		//optimal tiling lets the driver pick the layout it renders to fastest
+		info.tiling = VK_IMAGE_TILING_OPTIMAL;
+		info.usage = usageFlags;
+
+		return info;
+	}
+
+	VkImageViewCreateInfo imageview_create_info(VkFormat format, VkImage image, VkImageAspectFlags aspectFlags)
+	{
+		//build a image-view for the image to use for rendering
+		VkImageViewCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		info.pNext = nullptr;
+
+		info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		info.image = image;
+		info.format = format;
+		info.subresourceRange.baseMipLevel = 0;
+		info.subresourceRange.levelCount = 1;
+		info.subresourceRange.baseArrayLayer = 0;
+		info.subresourceRange.layerCount = 1;
+		info.subresourceRange.aspectMask = aspectFlags;
+
+		return info;
+	}
+
+	VkBufferCreateInfo buffer_create_info(VkDeviceSize size, VkBufferUsageFlags usage)
+	{
+		VkBufferCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		info.pNext = nullptr;
+
+		info.size = size;
+		info.usage = usage;
+
+		return info;
+	}
+
+	VkDescriptorSetLayoutBinding descriptorset_layout_binding(VkDescriptorType type, VkShaderStageFlags stageFlags, uint32_t binding)
+	{
+		VkDescriptorSetLayoutBinding setbind = {};
+		setbind.binding = binding;
+		setbind.descriptorCount = 1;
+		setbind.descriptorType = type;
+		setbind.pImmutableSamplers = nullptr;
+		setbind.stageFlags = stageFlags;
+
+		return setbind;
+	}
+
+	VkWriteDescriptorSet write_descriptor_buffer(VkDescriptorType type, VkDescriptorSet dstSet, const VkDescriptorBufferInfo* bufferInfo, uint32_t binding)
+	{
+		VkWriteDescriptorSet write = {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.pNext = nullptr;
+
+		write.dstBinding = binding;
+		write.dstSet = dstSet;
+		write.descriptorCount = 1;
+		write.descriptorType = type;
+		write.pBufferInfo = bufferInfo;
+
+		return write;
+	}
+
+	VkImageMemoryBarrier image_memory_barrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.pNext = nullptr;
+
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		return barrier;
+	}
+
 }
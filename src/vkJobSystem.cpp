@@ -0,0 +1,66 @@
+#include <vkJobSystem.h>
+#include <vkProfiler.h>
+
+void vkEngine::JobSystem::init(uint32_t workerCount)
+{
+	if (workerCount == 0)
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	m_Stop = false;
+	for (uint32_t i = 0; i < workerCount; i++)
+		m_Workers.emplace_back(&JobSystem::worker_loop, this);
+}
+
+void vkEngine::JobSystem::destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_Condition.notify_all();
+
+	for (std::thread& worker : m_Workers)
+		worker.join();
+	m_Workers.clear();
+}
+
+void vkEngine::JobSystem::submit(std::function<void()>&& job)
+{
+	if (m_Workers.empty())
+	{
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Jobs.push_back(std::move(job));
+	}
+	m_Condition.notify_one();
+}
+
+void vkEngine::JobSystem::worker_loop()
+{
+	PROFILE_THREAD_NAME("worker");
+
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this]() { return !m_Jobs.empty() || m_Stop; });
+
+			//drain the queue before stopping, submitters may be waiting on these jobs
+			if (m_Jobs.empty())
+				return;
+
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+		}
+
+		job();
+	}
+}
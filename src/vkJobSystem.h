@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace vkEngine {
+
+	//fixed pool of worker threads running jobs in submission order
+	class JobSystem
+	{
+	public:
+		//starts the workers, 0 picks one less than the number of hardware threads
+		void init(uint32_t workerCount = 0);
+
+		//finishes the queued jobs and joins the workers
+		void destroy();
+
+		uint32_t worker_count() const { return (uint32_t)m_Workers.size(); }
+
+		//runs the job on a worker, or right away on the calling thread when there are no workers
+		void submit(std::function<void()>&& job);
+
+		//same as submit, the future holds the job's result
+		template<typename F>
+		auto async(F&& function) -> std::future<decltype(function())>
+		{
+			using Result = decltype(function());
+
+			//std::function needs a copyable callable, the task itself is move-only
+			auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+			std::future<Result> result = task->get_future();
+			submit([task]() { (*task)(); });
+			return result;
+		}
+
+	private:
+		void worker_loop();
+
+		std::vector<std::thread> m_Workers;
+		std::deque<std::function<void()>> m_Jobs;
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		bool m_Stop{ false };
+	};
+
+}
@@ -0,0 +1,212 @@
+#include <vkLayoutCache.h>
+#include <vkInitializers.h>
+#include <vkProfiler.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+	//FNV-1a, fed one field at a time so struct padding never ends up in the hash
+	struct Hasher
+	{
+		uint64_t m_Hash{ 14695981039346656037ull };
+
+		void add(uint64_t value)
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				m_Hash ^= (value >> (i * 8)) & 0xff;
+				m_Hash *= 1099511628211ull;
+			}
+		}
+	};
+
+	bool same_binding(const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b)
+	{
+		return a.binding == b.binding && a.descriptorType == b.descriptorType && a.descriptorCount == b.descriptorCount
+			&& a.stageFlags == b.stageFlags && a.pImmutableSamplers == b.pImmutableSamplers;
+	}
+
+	bool same_push_constants(const VkPushConstantRange& a, const VkPushConstantRange& b)
+	{
+		return a.stageFlags == b.stageFlags && a.offset == b.offset && a.size == b.size;
+	}
+
+}
+
+void vkEngine::LayoutCache::init(VkDevice device)
+{
+	m_Device = device;
+}
+
+void vkEngine::LayoutCache::destroy()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	//pipeline layouts reference the set layouts, they go first
+	for (auto& bucket : m_PipelineLayouts)
+	{
+		for (PipelineLayout& layout : bucket.second)
+			vkDestroyPipelineLayout(m_Device, layout.m_Layout, nullptr);
+	}
+	for (auto& bucket : m_SetLayouts)
+	{
+		for (SetLayout& layout : bucket.second)
+			vkDestroyDescriptorSetLayout(m_Device, layout.m_Layout, nullptr);
+	}
+
+	m_PipelineLayouts.clear();
+	m_SetLayouts.clear();
+	m_PipelineLayoutCount = 0;
+	m_SetLayoutCount = 0;
+}
+
+VkDescriptorSetLayout vkEngine::LayoutCache::get_set_layout(std::vector<VkDescriptorSetLayoutBinding> bindings)
+{
+	std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+		return a.binding < b.binding;
+	});
+
+	Hasher hasher;
+	hasher.add(bindings.size());
+	for (const VkDescriptorSetLayoutBinding& binding : bindings)
+	{
+		hasher.add(binding.binding);
+		hasher.add(binding.descriptorType);
+		hasher.add(binding.descriptorCount);
+		hasher.add(binding.stageFlags);
+		hasher.add((uint64_t)(uintptr_t)binding.pImmutableSamplers);
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	std::vector<SetLayout>& bucket = m_SetLayouts[hasher.m_Hash];
+	for (const SetLayout& existing : bucket)
+	{
+		if (std::equal(existing.m_Bindings.begin(), existing.m_Bindings.end(), bindings.begin(), bindings.end(), same_binding))
+		{
+			m_Hits++;
+			return existing.m_Layout;
+		}
+	}
+
+	VkDescriptorSetLayoutCreateInfo setInfo = {};
+	setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setInfo.pNext = nullptr;
+
+	setInfo.flags = 0;
+	setInfo.bindingCount = (uint32_t)bindings.size();
+	setInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout layout;
+	if (vkCreateDescriptorSetLayout(m_Device, &setInfo, nullptr, &layout) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+
+	bucket.push_back({ std::move(bindings), layout });
+	m_SetLayoutCount++;
+	return layout;
+}
+
+VkPipelineLayout vkEngine::LayoutCache::get_pipeline_layout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstants)
+{
+	//set layouts come from this cache, so their handles already stand for their contents
+	Hasher hasher;
+	hasher.add(setLayouts.size());
+	for (VkDescriptorSetLayout setLayout : setLayouts)
+		hasher.add((uint64_t)setLayout);
+	hasher.add(pushConstants.size());
+	for (const VkPushConstantRange& range : pushConstants)
+	{
+		hasher.add(range.stageFlags);
+		hasher.add(range.offset);
+		hasher.add(range.size);
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	std::vector<PipelineLayout>& bucket = m_PipelineLayouts[hasher.m_Hash];
+	for (const PipelineLayout& existing : bucket)
+	{
+		if (existing.m_SetLayouts == setLayouts
+			&& std::equal(existing.m_PushConstants.begin(), existing.m_PushConstants.end(), pushConstants.begin(), pushConstants.end(), same_push_constants))
+		{
+			m_Hits++;
+			return existing.m_Layout;
+		}
+	}
+
+	VkPipelineLayoutCreateInfo layoutInfo = vkInit::pipeline_layout_create_info();
+	layoutInfo.setLayoutCount = (uint32_t)setLayouts.size();
+	layoutInfo.pSetLayouts = setLayouts.data();
+	layoutInfo.pushConstantRangeCount = (uint32_t)pushConstants.size();
+	layoutInfo.pPushConstantRanges = pushConstants.data();
+
+	VkPipelineLayout layout;
+	if (vkCreatePipelineLayout(m_Device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+
+	bucket.push_back({ setLayouts, pushConstants, layout });
+	m_PipelineLayoutCount++;
+	return layout;
+}
+
+VkPipelineLayout vkEngine::LayoutCache::get_pipeline_layout(const std::vector<const ShaderReflection*>& stages)
+{
+	PROFILE_SCOPE("LayoutCache::get_pipeline_layout");
+
+	//bindings per set, set numbers are dense in a pipeline layout
+	std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;
+	VkPushConstantRange pushConstants = { 0, 0, 0 };
+
+	for (const ShaderReflection* stage : stages)
+	{
+		if (!stage)
+			return VK_NULL_HANDLE;
+
+		for (const ReflectedBinding& reflected : stage->m_Bindings)
+		{
+			if (sets.size() <= reflected.m_Set)
+				sets.resize(reflected.m_Set + 1);
+			std::vector<VkDescriptorSetLayoutBinding>& set = sets[reflected.m_Set];
+
+			auto existing = std::find_if(set.begin(), set.end(), [&](const VkDescriptorSetLayoutBinding& binding) {
+				return binding.binding == reflected.m_Binding.binding;
+			});
+			if (existing == set.end())
+			{
+				set.push_back(reflected.m_Binding);
+				continue;
+			}
+
+			if (existing->descriptorType != reflected.m_Binding.descriptorType || existing->descriptorCount != reflected.m_Binding.descriptorCount)
+			{
+				std::cout << "Shader stages disagree about set " << reflected.m_Set << " binding " << reflected.m_Binding.binding << std::endl;
+				return VK_NULL_HANDLE;
+			}
+			existing->stageFlags |= reflected.m_Binding.stageFlags;
+		}
+
+		if (stage->m_PushConstantSize > 0)
+		{
+			pushConstants.stageFlags |= stage->m_Stage;
+			pushConstants.size = std::max(pushConstants.size, stage->m_PushConstantSize);
+		}
+	}
+
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	for (std::vector<VkDescriptorSetLayoutBinding>& set : sets)
+	{
+		//sets no stage uses still need a layout, an empty one
+		VkDescriptorSetLayout setLayout = get_set_layout(std::move(set));
+		if (setLayout == VK_NULL_HANDLE)
+			return VK_NULL_HANDLE;
+		setLayouts.push_back(setLayout);
+	}
+
+	std::vector<VkPushConstantRange> pushConstantRanges;
+	if (pushConstants.size > 0)
+		pushConstantRanges.push_back(pushConstants);
+
+	return get_pipeline_layout(setLayouts, pushConstantRanges);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vkTypes.h>
+#include <vkShaderReflection.h>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace vkEngine {
+
+	//descriptor set layouts and pipeline layouts keyed by a hash of their contents, every pipeline asking
+	//for the same resources gets the same handles. layouts live until destroy()
+	class LayoutCache
+	{
+	public:
+		void init(VkDevice device);
+
+		//destroys every layout
+		void destroy();
+
+		//the order of the bindings does not matter. immutable samplers are not supported
+		VkDescriptorSetLayout get_set_layout(std::vector<VkDescriptorSetLayoutBinding> bindings);
+
+		VkPipelineLayout get_pipeline_layout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstants);
+
+		//merges the stages' bindings, a binding used by several stages is visible to all of them. the push constant
+		//blocks become a single range from offset 0 shared by every stage that has one.
+		//VK_NULL_HANDLE if a stage is missing or two stages disagree about a binding
+		VkPipelineLayout get_pipeline_layout(const std::vector<const ShaderReflection*>& stages);
+
+		size_t get_set_layout_count() const { return m_SetLayoutCount; }
+		size_t get_pipeline_layout_count() const { return m_PipelineLayoutCount; }
+		uint64_t get_hit_count() const { return m_Hits; }
+
+	private:
+		struct SetLayout
+		{
+			std::vector<VkDescriptorSetLayoutBinding> m_Bindings;
+			VkDescriptorSetLayout m_Layout;
+		};
+
+		struct PipelineLayout
+		{
+			std::vector<VkDescriptorSetLayout> m_SetLayouts;
+			std::vector<VkPushConstantRange> m_PushConstants;
+			VkPipelineLayout m_Layout;
+		};
+
+		VkDevice m_Device{ VK_NULL_HANDLE };
+
+		//layouts are asked for from init graph steps running on different workers
+		std::mutex m_Mutex;
+		//every entry of a bucket has the same hash, more than one only on a collision
+		std::unordered_map<uint64_t, std::vector<SetLayout>> m_SetLayouts;
+		std::unordered_map<uint64_t, std::vector<PipelineLayout>> m_PipelineLayouts;
+		size_t m_SetLayoutCount{ 0 };
+		size_t m_PipelineLayoutCount{ 0 };
+		uint64_t m_Hits{ 0 };
+	};
+
+}
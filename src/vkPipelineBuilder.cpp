@@ -0,0 +1,166 @@
+#include <vkPipelineBuilder.h>
+#include <vkProfiler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+void vkEngine::PipelineBuilder::fill_create_info(VkRenderPass pass, PipelineCreateInfo& outInfo) const
+{
+			//make viewport state from our stored viewport and scissor.
+			//at the moment we won't support multiple viewports or scissors
+
+			VkPipelineViewportStateCreateInfo& viewportState = outInfo.m_ViewportState;
+			viewportState = {};
+			viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+			viewportState.pNext = nullptr;
+
+			viewportState.viewportCount = 1;
+			viewportState.pViewports = m_DynamicViewport ? nullptr : &m_Viewport;
+			viewportState.scissorCount = 1;
+			viewportState.pScissors = m_DynamicViewport ? nullptr : &m_Scissor;
+
+			//the counts above still apply, only the values come from the command buffer
+			static const VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+			VkPipelineDynamicStateCreateInfo& dynamicState = outInfo.m_DynamicState;
+			dynamicState = {};
+			dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+			dynamicState.pNext = nullptr;
+
+			dynamicState.dynamicStateCount = 2;
+			dynamicState.pDynamicStates = dynamicStates;
+
+			//setup dummy color blending. We aren't using transparent objects yet
+			//the blending is just "no blend", but we do write to the color attachment
+			VkPipelineColorBlendStateCreateInfo& colorBlending = outInfo.m_ColorBlending;
+			colorBlending = {};
+			colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+			colorBlending.pNext = nullptr;
+
+			colorBlending.logicOpEnable = VK_FALSE;
+			colorBlending.logicOp = VK_LOGIC_OP_COPY;
+			colorBlending.attachmentCount = 1;
+			colorBlending.pAttachments = &m_ColorBlendAttachment;
+
+
+
+			//build the actual pipeline
+			//we now use all of the info structs we have been writing into into this one to create the pipeline
+			VkGraphicsPipelineCreateInfo& pipelineInfo = outInfo.m_PipelineInfo;
+			pipelineInfo = {};
+			pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+			pipelineInfo.pNext = nullptr;
+
+			pipelineInfo.stageCount = m_ShaderStages.size();
+			pipelineInfo.pStages = m_ShaderStages.data();
+			pipelineInfo.pVertexInputState = &m_VertexInputInfo;
+			pipelineInfo.pInputAssemblyState = &m_InputAssembly;
+			pipelineInfo.pViewportState = &viewportState;
+			pipelineInfo.pRasterizationState = &m_Rasterizer;
+			pipelineInfo.pMultisampleState = &m_Multisampling;
+			pipelineInfo.pColorBlendState = &colorBlending;
+			pipelineInfo.pDynamicState = m_DynamicViewport ? &dynamicState : nullptr;
+			pipelineInfo.layout = m_PipelineLayout;
+			pipelineInfo.renderPass = pass;
+			pipelineInfo.subpass = 0;
+			pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+}
+
+VkPipeline vkEngine::PipelineBuilder::build_pipeline(VkDevice device, VkRenderPass pass, VkPipelineCache cache)
+{
+	PROFILE_SCOPE("build_pipeline");
+	PipelineCreateInfo createInfo;
+	fill_create_info(pass, createInfo);
+
+			//it's easy to error out on create graphics pipeline, so we handle it a bit better than the common VK_CHECK case
+			VkPipeline newPipeline;
+			if (vkCreateGraphicsPipelines(
+				device, cache, 1, &createInfo.m_PipelineInfo, nullptr, &newPipeline) != VK_SUCCESS) {
+				std::cout << "failed to create pipeline\n";
+				return VK_NULL_HANDLE; // failed to create graphics pipeline
+			}
+			else
+			{
+				return newPipeline;
+			}
+
+
+}
+
+std::vector<VkPipeline> vkEngine::PipelineBuilder::build_pipelines(VkDevice device, VkRenderPass pass, VkPipelineCache cache,
+	const std::vector<PipelineBuilder>& builders, JobSystem& jobs)
+{
+	PROFILE_SCOPE("build_pipelines");
+
+	//shared with the jobs, which may only get to run after every batch was already taken and this returned
+	struct Batches
+	{
+		std::vector<VkGraphicsPipelineCreateInfo> m_Infos;
+		std::vector<VkPipeline> m_Pipelines;
+		uint32_t m_BatchCount;
+		uint32_t m_BatchSize;
+		std::atomic<uint32_t> m_NextBatch{ 0 };
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		uint32_t m_FinishedBatches{ 0 };
+		bool m_Failed{ false };
+	};
+
+	if (builders.empty())
+		return {};
+
+	//the create infos point into the builders and into createInfos, both outlive every batch since we wait for all of them
+	std::vector<PipelineCreateInfo> createInfos(builders.size());
+	auto batches = std::make_shared<Batches>();
+	batches->m_Infos.resize(builders.size());
+	batches->m_Pipelines.resize(builders.size(), VK_NULL_HANDLE);
+	for (size_t i = 0; i < builders.size(); i++)
+	{
+		builders[i].fill_create_info(pass, createInfos[i]);
+		batches->m_Infos[i] = createInfos[i].m_PipelineInfo;
+	}
+
+	//at most one batch per thread that can work on them, each compiled with a single multi-create call.
+	//the count follows from the rounded up size, otherwise the last batches could start past the end
+	uint32_t pipelineCount = (uint32_t)builders.size();
+	uint32_t threadCount = jobs.worker_count() + 1;
+	batches->m_BatchSize = (pipelineCount + threadCount - 1) / threadCount;
+	batches->m_BatchCount = std::min(pipelineCount, (pipelineCount + batches->m_BatchSize - 1) / batches->m_BatchSize);
+
+	//whoever gets there first takes the next batch. the caller joins in, so this can not deadlock
+	//even when it runs on a worker itself and every other worker is busy
+	auto work = [device, cache, batches]() {
+		uint32_t batch;
+		while ((batch = batches->m_NextBatch.fetch_add(1)) < batches->m_BatchCount)
+		{
+			PROFILE_SCOPE("build_pipelines.batch");
+			uint32_t begin = batch * batches->m_BatchSize;
+			uint32_t count = std::min(batches->m_BatchSize, (uint32_t)batches->m_Infos.size() - begin);
+
+			//pipelines that fail come back as VK_NULL_HANDLE, the others in the batch are still created
+			VkResult result = vkCreateGraphicsPipelines(device, cache, count, &batches->m_Infos[begin], nullptr, &batches->m_Pipelines[begin]);
+
+			std::lock_guard<std::mutex> lock(batches->m_Mutex);
+			batches->m_Failed |= result != VK_SUCCESS;
+			batches->m_FinishedBatches++;
+			batches->m_Condition.notify_all();
+		}
+	};
+
+	for (uint32_t i = 1; i < batches->m_BatchCount; i++)
+		jobs.submit(work);
+	work();
+
+	std::unique_lock<std::mutex> lock(batches->m_Mutex);
+	batches->m_Condition.wait(lock, [&]() { return batches->m_FinishedBatches == batches->m_BatchCount; });
+
+	if (batches->m_Failed)
+		std::cout << "failed to create some of " << builders.size() << " pipelines\n";
+
+	return batches->m_Pipelines;
+}
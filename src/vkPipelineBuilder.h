@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vkTypes.h>
+#include <vkJobSystem.h>
+#include <vector>
+
+namespace vkEngine {
+
+	//create info of one pipeline together with the states it points to
+	struct PipelineCreateInfo
+	{
+		VkPipelineViewportStateCreateInfo m_ViewportState;
+		VkPipelineColorBlendStateCreateInfo m_ColorBlending;
+		VkPipelineDynamicStateCreateInfo m_DynamicState;
+		VkGraphicsPipelineCreateInfo m_PipelineInfo;
+	};
+
+	class PipelineBuilder 
+	{
+
+
+
+	public: 
+		std::vector<VkPipelineShaderStageCreateInfo> m_ShaderStages;
+		VkPipelineVertexInputStateCreateInfo m_VertexInputInfo;
+		VkPipelineInputAssemblyStateCreateInfo m_InputAssembly;
+		//only baked into the pipeline when m_DynamicViewport is off
+		VkViewport m_Viewport;
+		VkRect2D m_Scissor;
+		//viewport and scissor are set with vkCmdSetViewport/vkCmdSetScissor while recording, so one pipeline fits every resolution
+		bool m_DynamicViewport{ true };
+		VkPipelineRasterizationStateCreateInfo m_Rasterizer;
+		VkPipelineColorBlendAttachmentState m_ColorBlendAttachment;
+		VkPipelineMultisampleStateCreateInfo m_Multisampling;
+		VkPipelineLayout m_PipelineLayout;
+	public:
+		//cache may be VK_NULL_HANDLE
+		VkPipeline build_pipeline(VkDevice device, VkRenderPass pass, VkPipelineCache cache = VK_NULL_HANDLE);
+
+		//builds every builder's pipeline, split into batches that each go through one vkCreateGraphicsPipelines call
+		//on the workers and the calling thread. Returns the pipelines in builder order, VK_NULL_HANDLE for those that failed
+		static std::vector<VkPipeline> build_pipelines(VkDevice device, VkRenderPass pass, VkPipelineCache cache,
+			const std::vector<PipelineBuilder>& builders, JobSystem& jobs);
+
+		//points outInfo at the builder's state, both have to stay alive while the pipeline is created
+		void fill_create_info(VkRenderPass pass, PipelineCreateInfo& outInfo) const;
+
+
+
+
+	};
+
+}
@@ -0,0 +1,135 @@
+#include <vkPipelineCache.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+void vkEngine::PipelineCache::init(VkDevice device, VkPhysicalDevice gpu, const std::string& path)
+{
+	m_Device = device;
+	m_Path = path;
+	m_LoadedSize = 0;
+
+	std::vector<char> data;
+	if (!m_Path.empty())
+	{
+		std::ifstream file(m_Path, std::ios::ate | std::ios::binary);
+		if (file.is_open())
+		{
+			data.resize((size_t)file.tellg());
+			file.seekg(0);
+			file.read(data.data(), data.size());
+		}
+	}
+
+	if (!data.empty())
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(gpu, &properties);
+
+		if (!validate_header(data, properties))
+			data.clear();
+	}
+
+	VkPipelineCacheCreateInfo cacheInfo = {};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.pNext = nullptr;
+
+	cacheInfo.initialDataSize = data.size();
+	cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+	if (vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_Cache) == VK_SUCCESS)
+	{
+		m_LoadedSize = data.size();
+		return;
+	}
+
+	//the header matched but the driver still refused the contents, an empty cache is always accepted
+	if (!data.empty())
+	{
+		std::cout << "The driver rejected the pipeline cache in " << m_Path << ", starting empty" << std::endl;
+		cacheInfo.initialDataSize = 0;
+		cacheInfo.pInitialData = nullptr;
+		if (vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_Cache) == VK_SUCCESS)
+			return;
+	}
+
+	//pipelines still build without a cache, just slower
+	std::cout << "Failed to create a pipeline cache, pipelines are compiled from scratch" << std::endl;
+	m_Cache = VK_NULL_HANDLE;
+}
+
+bool vkEngine::PipelineCache::validate_header(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties)
+{
+	VkPipelineCacheHeaderVersionOne header;
+	if (data.size() < sizeof(header))
+	{
+		std::cout << "Pipeline cache file is too small for a header, ignoring it" << std::endl;
+		return false;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+
+	if (header.headerSize < sizeof(header) || header.headerSize > data.size())
+	{
+		std::cout << "Pipeline cache file has a corrupt header, ignoring it" << std::endl;
+		return false;
+	}
+	if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+	{
+		std::cout << "Pipeline cache file has an unknown header version, ignoring it" << std::endl;
+		return false;
+	}
+
+	//written by another GPU or another driver version, which would at best ignore the data
+	if (header.vendorID != properties.vendorID || header.deviceID != properties.deviceID
+		|| memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+	{
+		std::cout << "Pipeline cache file was written for a different device or driver, ignoring it" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool vkEngine::PipelineCache::save() const
+{
+	if (m_Cache == VK_NULL_HANDLE || m_Path.empty())
+		return false;
+
+	size_t size = 0;
+	if (vkGetPipelineCacheData(m_Device, m_Cache, &size, nullptr) != VK_SUCCESS || size == 0)
+		return false;
+
+	std::vector<char> data(size);
+	if (vkGetPipelineCacheData(m_Device, m_Cache, &size, data.data()) != VK_SUCCESS)
+		return false;
+
+	//write next to the old file and swap it in, so a crash halfway never leaves a truncated cache behind
+	std::string tempPath = m_Path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cout << "Could not write the pipeline cache to " << tempPath << std::endl;
+			return false;
+		}
+		file.write(data.data(), size);
+		if (!file)
+		{
+			std::cout << "Could not write the pipeline cache to " << tempPath << std::endl;
+			return false;
+		}
+	}
+
+	//rename does not replace an existing file on Windows
+	std::remove(m_Path.c_str());
+	if (std::rename(tempPath.c_str(), m_Path.c_str()) != 0)
+	{
+		std::cout << "Could not move the pipeline cache to " << m_Path << std::endl;
+		return false;
+	}
+
+	std::cout << "Saved " << size << " bytes of pipeline cache to " << m_Path << std::endl;
+	return true;
+}
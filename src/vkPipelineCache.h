@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vkTypes.h>
+#include <string>
+#include <vector>
+
+namespace vkEngine {
+
+	//VkPipelineCache persisted between runs. the file is only used when its header was written by the same
+	//driver for the same device, anything else starts from an empty cache
+	class PipelineCache
+	{
+	public:
+		//creates the cache, seeded from the file at path if it is valid for gpu. an empty path keeps the cache in memory only
+		void init(VkDevice device, VkPhysicalDevice gpu, const std::string& path);
+
+		//writes the current contents to the file the cache was created for. Returns false if nothing was written
+		bool save() const;
+
+		//VK_NULL_HANDLE if the cache could not be created, pipelines then build without one
+		VkPipelineCache get() const { return m_Cache; }
+
+		//true when the cache was seeded from disk
+		bool is_warm() const { return m_LoadedSize > 0; }
+		size_t get_loaded_size() const { return m_LoadedSize; }
+		const std::string& get_path() const { return m_Path; }
+
+	private:
+		//checks the header the driver put in front of the data against this device. prints why a file is rejected
+		static bool validate_header(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties);
+
+		VkDevice m_Device{ VK_NULL_HANDLE };
+		VkPipelineCache m_Cache{ VK_NULL_HANDLE };
+		std::string m_Path;
+		size_t m_LoadedSize{ 0 };
+	};
+
+}
@@ -0,0 +1,168 @@
+#include <vkPipelinePermutations.h>
+#include <vkProfiler.h>
+
+#include <chrono>
+#include <iostream>
+
+bool vkEngine::PipelinePermutations::init(PipelineRegistry& registry, JobSystem& jobs, VkRenderPass pass, const PipelineBuilder& base,
+	const std::vector<std::string>& stageFiles, const std::vector<std::vector<uint32_t>>& variants, uint32_t fallbackVariant)
+{
+	m_Registry = &registry;
+	m_Jobs = &jobs;
+	m_Pass = pass;
+	m_Fallback = fallbackVariant;
+	m_Base = base;
+	m_StageFiles = stageFiles;
+
+	m_Variants.resize(variants.size());
+	for (size_t i = 0; i < variants.size(); i++)
+	{
+		Variant& variant = m_Variants[i];
+		variant.m_Constants = variants[i];
+
+		//every constant is 32 bits, constant_id j sits at word j
+		for (uint32_t j = 0; j < (uint32_t)variant.m_Constants.size(); j++)
+			variant.m_Entries.push_back({ j, j * (uint32_t)sizeof(uint32_t), sizeof(uint32_t) });
+
+		variant.m_Info.mapEntryCount = (uint32_t)variant.m_Entries.size();
+		variant.m_Info.pMapEntries = variant.m_Entries.data();
+		variant.m_Info.dataSize = variant.m_Constants.size() * sizeof(uint32_t);
+		variant.m_Info.pData = variant.m_Constants.data();
+	}
+
+	//there has to be something to draw with while the other variants compile
+	Variant& fallback = m_Variants[m_Fallback];
+	fallback.m_Id = m_Registry->get_or_build({ specialize(m_Base, fallback) }, m_Pass, jobs)[0];
+	return fallback.m_Id != INVALID_PIPELINE;
+}
+
+void vkEngine::PipelinePermutations::destroy()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_CompilesDone.wait(lock, [this]() { return m_CompilesInFlight == 0; });
+
+	for (Variant& variant : m_Variants)
+	{
+		if (variant.m_Compiled != VK_NULL_HANDLE)
+			vkDestroyPipeline(m_Registry->get_device(), variant.m_Compiled, nullptr);
+		variant.m_Compiled = VK_NULL_HANDLE;
+	}
+}
+
+vkEngine::PipelineBuilder vkEngine::PipelinePermutations::specialize(const PipelineBuilder& base, const Variant& variant) const
+{
+	PipelineBuilder builder = base;
+	for (VkPipelineShaderStageCreateInfo& stage : builder.m_ShaderStages)
+		stage.pSpecializationInfo = variant.m_Entries.empty() ? nullptr : &variant.m_Info;
+	return builder;
+}
+
+vkEngine::PipelineId vkEngine::PipelinePermutations::get(uint32_t variant)
+{
+	PipelineBuilder builder;
+	uint64_t generation;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		Variant& entry = m_Variants[variant];
+		if (entry.m_Id != INVALID_PIPELINE)
+			return entry.m_Id;
+
+		//finished since the last call, compiles of an older base never get here
+		if (entry.m_Compiled != VK_NULL_HANDLE)
+		{
+			entry.m_Id = m_Registry->insert(specialize(m_Base, entry), m_Pass, entry.m_Compiled);
+			entry.m_Compiled = VK_NULL_HANDLE;
+			return entry.m_Id;
+		}
+
+		if (entry.m_Compiling || entry.m_Failed)
+			return get_fallback();
+
+		entry.m_Compiling = true;
+		m_CompilesInFlight++;
+		builder = specialize(m_Base, entry);
+		generation = m_Generation;
+	}
+
+	//without workers the job runs right here, so it can not be submitted under the lock
+	m_Jobs->submit([this, variant, builder, generation]() {
+		compile(variant, builder, generation);
+	});
+	return get_fallback();
+}
+
+void vkEngine::PipelinePermutations::compile(uint32_t variant, PipelineBuilder builder, uint64_t generation)
+{
+	PROFILE_SCOPE("PipelinePermutations::compile");
+	auto start = std::chrono::steady_clock::now();
+
+	VkDevice device = m_Registry->get_device();
+	VkPipeline pipeline = builder.build_pipeline(device, m_Pass, m_Registry->get_cache());
+	double compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	Variant& entry = m_Variants[variant];
+	entry.m_Compiling = false;
+
+	if (generation != m_Generation)
+	{
+		//the shaders changed while compiling, the next get() starts over with the new ones
+		if (pipeline != VK_NULL_HANDLE)
+			vkDestroyPipeline(device, pipeline, nullptr);
+	}
+	else if (pipeline == VK_NULL_HANDLE)
+	{
+		std::cout << "Failed to compile pipeline variant " << variant << ", drawing it with the fallback" << std::endl;
+		entry.m_Failed = true;
+	}
+	else
+	{
+		std::cout << "Compiled pipeline variant " << variant << " in " << compileMs << " ms" << std::endl;
+		entry.m_Compiled = pipeline;
+	}
+
+	m_CompilesInFlight--;
+	m_CompilesDone.notify_all();
+}
+
+bool vkEngine::PipelinePermutations::with_shader(const std::string& fileName, VkShaderModule shaderModule, PipelineBuilder& outBase) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	outBase = m_Base;
+	bool usesShader = false;
+	for (size_t stage = 0; stage < m_StageFiles.size() && stage < outBase.m_ShaderStages.size(); stage++)
+	{
+		const std::string& stageFile = m_StageFiles[stage];
+		if (stageFile.substr(stageFile.find_last_of("/\\") + 1) == fileName)
+		{
+			outBase.m_ShaderStages[stage].module = shaderModule;
+			usesShader = true;
+		}
+	}
+	return usesShader;
+}
+
+std::vector<std::pair<vkEngine::PipelineId, vkEngine::PipelineBuilder>> vkEngine::PipelinePermutations::set_base(const PipelineBuilder& base)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	m_Base = base;
+	m_Generation++;
+
+	std::vector<std::pair<PipelineId, PipelineBuilder>> built;
+	for (Variant& variant : m_Variants)
+	{
+		//compiled from the old shaders, nothing drew with it yet
+		if (variant.m_Compiled != VK_NULL_HANDLE)
+			vkDestroyPipeline(m_Registry->get_device(), variant.m_Compiled, nullptr);
+		variant.m_Compiled = VK_NULL_HANDLE;
+		variant.m_Failed = false;
+
+		if (variant.m_Id != INVALID_PIPELINE)
+			built.emplace_back(variant.m_Id, specialize(m_Base, variant));
+	}
+	return built;
+}
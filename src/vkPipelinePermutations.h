@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vkTypes.h>
+#include <vkJobSystem.h>
+#include <vkPipelineBuilder.h>
+#include <vkPipelineRegistry.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vkEngine {
+
+	//variants of one pipeline that only differ in specialization constants, so they share the shader modules.
+	//variant i sets constant_id j to variants[i][j] in every stage. one variant is the fallback and compiled up front,
+	//the others are compiled on a worker the first time they are asked for and kept in the registry from then on
+	class PipelinePermutations
+	{
+	public:
+		//stageFiles names the spir-v file of every stage of base, to find the variants a reloaded shader affects.
+		//compiles the fallback variant on the calling thread, returns false if that fails
+		bool init(PipelineRegistry& registry, JobSystem& jobs, VkRenderPass pass, const PipelineBuilder& base,
+			const std::vector<std::string>& stageFiles, const std::vector<std::vector<uint32_t>>& variants, uint32_t fallbackVariant = 0);
+
+		//waits for compiles still running and destroys pipelines that never made it into the registry
+		void destroy();
+
+		uint32_t variant_count() const { return (uint32_t)m_Variants.size(); }
+
+		//never blocks on a compile. the variant's pipeline once it is ready, the fallback's until then.
+		//pipelines are added to the registry here, every call has to come from the thread that owns the registry
+		PipelineId get(uint32_t variant);
+
+		PipelineId get_fallback() const { return m_Variants[m_Fallback].m_Id; }
+
+		//copy of the base state with the stages built from fileName switched to shaderModule. false if no stage uses the file
+		bool with_shader(const std::string& fileName, VkShaderModule shaderModule, PipelineBuilder& outBase) const;
+
+		//variants are built from base from now on, compiles still running are thrown away when they finish.
+		//Returns the id and new state of every variant in the registry, to rebuild them
+		std::vector<std::pair<PipelineId, PipelineBuilder>> set_base(const PipelineBuilder& base);
+
+	private:
+		struct Variant
+		{
+			std::vector<uint32_t> m_Constants;
+			std::vector<VkSpecializationMapEntry> m_Entries;
+			VkSpecializationInfo m_Info;
+			PipelineId m_Id{ INVALID_PIPELINE };
+
+			//compiled on a worker, waiting for get() to put it in the registry
+			VkPipeline m_Compiled{ VK_NULL_HANDLE };
+			bool m_Compiling{ false };
+			//not retried until the base changes
+			bool m_Failed{ false };
+		};
+
+		//the base with the variant's constants in every stage, pointing into the variant
+		PipelineBuilder specialize(const PipelineBuilder& base, const Variant& variant) const;
+
+		//runs on a worker
+		void compile(uint32_t variant, PipelineBuilder builder, uint64_t generation);
+
+		PipelineRegistry* m_Registry{ nullptr };
+		JobSystem* m_Jobs{ nullptr };
+		VkRenderPass m_Pass{ VK_NULL_HANDLE };
+		uint32_t m_Fallback{ 0 };
+
+		mutable std::mutex m_Mutex;
+		PipelineBuilder m_Base;
+		//bumped with every new base, compiles of an older one are stale
+		uint64_t m_Generation{ 0 };
+		std::vector<std::string> m_StageFiles;
+		//filled once by init, builders point at the specialization infos in here
+		std::vector<Variant> m_Variants;
+
+		uint32_t m_CompilesInFlight{ 0 };
+		std::condition_variable m_CompilesDone;
+	};
+
+}
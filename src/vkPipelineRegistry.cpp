@@ -0,0 +1,215 @@
+#include <vkPipelineRegistry.h>
+#include <vkPipelineBuilder.h>
+#include <vkProfiler.h>
+
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+namespace {
+
+	//appends raw field values to a key. only for scalars and structs without padding or pointers
+	struct KeyWriter
+	{
+		std::string m_Key;
+
+		template<typename T>
+		void add(const T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "key fields must be plain values");
+			m_Key.append((const char*)&value, sizeof(T));
+		}
+
+		void add_bytes(const void* data, size_t size)
+		{
+			add(size);
+			m_Key.append((const char*)data, size);
+		}
+
+		void add_string(const char* text)
+		{
+			add_bytes(text, text ? strlen(text) : 0);
+		}
+	};
+
+}
+
+void vkEngine::PipelineRegistry::init(VkDevice device, VkPipelineCache cache)
+{
+	m_Device = device;
+	m_Cache = cache;
+}
+
+void vkEngine::PipelineRegistry::destroy()
+{
+	for (VkPipeline pipeline : m_Pipelines)
+		vkDestroyPipeline(m_Device, pipeline, nullptr);
+
+	m_Pipelines.clear();
+	m_Lookup.clear();
+}
+
+std::string vkEngine::PipelineRegistry::make_key(const PipelineBuilder& builder, VkRenderPass pass)
+{
+	KeyWriter key;
+
+	key.add((uint64_t)pass);
+	key.add((uint64_t)builder.m_PipelineLayout);
+
+	key.add(builder.m_ShaderStages.size());
+	for (const VkPipelineShaderStageCreateInfo& stage : builder.m_ShaderStages)
+	{
+		key.add(stage.flags);
+		key.add(stage.stage);
+		key.add((uint64_t)stage.module);
+		key.add_string(stage.pName);
+
+		const VkSpecializationInfo* specialization = stage.pSpecializationInfo;
+		key.add(specialization ? specialization->mapEntryCount : 0u);
+		if (specialization)
+		{
+			key.add_bytes(specialization->pMapEntries, specialization->mapEntryCount * sizeof(VkSpecializationMapEntry));
+			key.add_bytes(specialization->pData, specialization->dataSize);
+		}
+	}
+
+	const VkPipelineVertexInputStateCreateInfo& vertexInput = builder.m_VertexInputInfo;
+	key.add(vertexInput.flags);
+	key.add_bytes(vertexInput.pVertexBindingDescriptions, vertexInput.vertexBindingDescriptionCount * sizeof(VkVertexInputBindingDescription));
+	key.add_bytes(vertexInput.pVertexAttributeDescriptions, vertexInput.vertexAttributeDescriptionCount * sizeof(VkVertexInputAttributeDescription));
+
+	key.add(builder.m_InputAssembly.flags);
+	key.add(builder.m_InputAssembly.topology);
+	key.add(builder.m_InputAssembly.primitiveRestartEnable);
+
+	//dynamic viewports are not part of the pipeline, builders that only differ in them share one
+	key.add(builder.m_DynamicViewport);
+	if (!builder.m_DynamicViewport)
+	{
+		key.add(builder.m_Viewport);
+		key.add(builder.m_Scissor);
+	}
+
+	const VkPipelineRasterizationStateCreateInfo& rasterizer = builder.m_Rasterizer;
+	key.add(rasterizer.flags);
+	key.add(rasterizer.depthClampEnable);
+	key.add(rasterizer.rasterizerDiscardEnable);
+	key.add(rasterizer.polygonMode);
+	key.add(rasterizer.cullMode);
+	key.add(rasterizer.frontFace);
+	key.add(rasterizer.depthBiasEnable);
+	key.add(rasterizer.depthBiasConstantFactor);
+	key.add(rasterizer.depthBiasClamp);
+	key.add(rasterizer.depthBiasSlopeFactor);
+	key.add(rasterizer.lineWidth);
+
+	key.add(builder.m_ColorBlendAttachment);
+
+	const VkPipelineMultisampleStateCreateInfo& multisampling = builder.m_Multisampling;
+	key.add(multisampling.flags);
+	key.add(multisampling.rasterizationSamples);
+	key.add(multisampling.sampleShadingEnable);
+	key.add(multisampling.minSampleShading);
+	key.add(multisampling.alphaToCoverageEnable);
+	key.add(multisampling.alphaToOneEnable);
+	//one mask word per 32 samples
+	uint32_t maskWords = multisampling.pSampleMask ? ((uint32_t)multisampling.rasterizationSamples + 31) / 32 : 0;
+	key.add_bytes(multisampling.pSampleMask, maskWords * sizeof(VkSampleMask));
+
+	return key.m_Key;
+}
+
+std::vector<vkEngine::PipelineId> vkEngine::PipelineRegistry::get_or_build(const std::vector<PipelineBuilder>& builders, VkRenderPass pass, JobSystem& jobs)
+{
+	PROFILE_SCOPE("PipelineRegistry::get_or_build");
+
+	std::vector<PipelineId> ids(builders.size(), INVALID_PIPELINE);
+
+	//builders that need compiling, and for each of them every request it answers
+	std::vector<PipelineBuilder> missing;
+	std::vector<std::string> missingKeys;
+	std::unordered_map<std::string, uint32_t> missingIndices;
+	std::vector<std::vector<uint32_t>> requesters;
+
+	for (uint32_t i = 0; i < builders.size(); i++)
+	{
+		std::string key = make_key(builders[i], pass);
+
+		auto existing = m_Lookup.find(key);
+		if (existing != m_Lookup.end())
+		{
+			ids[i] = existing->second;
+			m_SharedCount++;
+			continue;
+		}
+
+		auto pending = missingIndices.find(key);
+		if (pending != missingIndices.end())
+		{
+			requesters[pending->second].push_back(i);
+			m_SharedCount++;
+			continue;
+		}
+
+		missingIndices.emplace(key, (uint32_t)missing.size());
+		missing.push_back(builders[i]);
+		missingKeys.push_back(std::move(key));
+		requesters.push_back({ i });
+	}
+
+	if (missing.empty())
+		return ids;
+
+	std::vector<VkPipeline> pipelines = PipelineBuilder::build_pipelines(m_Device, pass, m_Cache, missing, jobs);
+
+	for (size_t m = 0; m < missing.size(); m++)
+	{
+		//failures are not registered, asking again retries them
+		if (pipelines[m] == VK_NULL_HANDLE)
+			continue;
+
+		PipelineId id = (PipelineId)m_Pipelines.size();
+		m_Pipelines.push_back(pipelines[m]);
+		m_Lookup.emplace(std::move(missingKeys[m]), id);
+
+		for (uint32_t requester : requesters[m])
+			ids[requester] = id;
+	}
+
+	return ids;
+}
+
+vkEngine::PipelineId vkEngine::PipelineRegistry::insert(const PipelineBuilder& builder, VkRenderPass pass, VkPipeline pipeline)
+{
+	std::string key = make_key(builder, pass);
+
+	auto existing = m_Lookup.find(key);
+	if (existing != m_Lookup.end())
+	{
+		//nothing has used the duplicate yet
+		vkDestroyPipeline(m_Device, pipeline, nullptr);
+		m_SharedCount++;
+		return existing->second;
+	}
+
+	PipelineId id = (PipelineId)m_Pipelines.size();
+	m_Pipelines.push_back(pipeline);
+	m_Lookup.emplace(std::move(key), id);
+	return id;
+}
+
+VkPipeline vkEngine::PipelineRegistry::replace(PipelineId id, VkPipeline pipeline)
+{
+	//the key describes the state the id was built from, which it does not hold anymore
+	for (auto entry = m_Lookup.begin(); entry != m_Lookup.end();)
+	{
+		if (entry->second == id)
+			entry = m_Lookup.erase(entry);
+		else
+			++entry;
+	}
+
+	VkPipeline previous = m_Pipelines[id];
+	m_Pipelines[id] = pipeline;
+	return previous;
+}
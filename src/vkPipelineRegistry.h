@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vkTypes.h>
+#include <vkJobSystem.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vkEngine {
+
+	class PipelineBuilder;
+
+	//index of a pipeline in the PipelineRegistry
+	using PipelineId = uint32_t;
+	constexpr PipelineId INVALID_PIPELINE = UINT32_MAX;
+
+	//owns every graphics pipeline, keyed by the complete builder state and render pass.
+	//requesting a pipeline identical to one built before returns the existing one instead of compiling it again
+	class PipelineRegistry
+	{
+	public:
+		void init(VkDevice device, VkPipelineCache cache);
+
+		//destroys every pipeline in the registry
+		void destroy();
+
+		//returns one id per builder, building only pipelines that are not in the registry yet, in parallel on jobs.
+		//duplicates within builders are built once. INVALID_PIPELINE for builders that failed to compile
+		std::vector<PipelineId> get_or_build(const std::vector<PipelineBuilder>& builders, VkRenderPass pass, JobSystem& jobs);
+
+		//O(1), meant for draw time. not safe against a concurrent get_or_build
+		VkPipeline get(PipelineId id) const { return m_Pipelines[id]; }
+
+		//registers a pipeline built elsewhere from builder. if the registry has one for that state already,
+		//the new one is destroyed and the existing id returned
+		PipelineId insert(const PipelineBuilder& builder, VkRenderPass pass, VkPipeline pipeline);
+
+		//puts a pipeline built elsewhere under the id, e.g. after its shaders were reloaded, and returns the one it replaces.
+		//the id no longer answers requests for the old state. not safe against a concurrent get
+		VkPipeline replace(PipelineId id, VkPipeline pipeline);
+
+		VkDevice get_device() const { return m_Device; }
+		VkPipelineCache get_cache() const { return m_Cache; }
+
+		size_t size() const { return m_Pipelines.size(); }
+		//how many requests were answered with an existing pipeline
+		uint64_t get_shared_count() const { return m_SharedCount; }
+
+	private:
+		//every field of the builder that ends up in the pipeline, with pointed-to arrays inlined. never contains pointers
+		static std::string make_key(const PipelineBuilder& builder, VkRenderPass pass);
+
+		VkDevice m_Device{ VK_NULL_HANDLE };
+		VkPipelineCache m_Cache{ VK_NULL_HANDLE };
+
+		std::unordered_map<std::string, PipelineId> m_Lookup;
+		std::vector<VkPipeline> m_Pipelines;
+		uint64_t m_SharedCount{ 0 };
+	};
+
+}
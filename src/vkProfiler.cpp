@@ -0,0 +1,122 @@
+#include <vkProfiler.h>
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+	struct Event
+	{
+		const char* m_Name;
+		int64_t m_StartNs;
+		int64_t m_DurationNs;
+	};
+
+	//written only by its thread, the exporter reads up to m_Written
+	struct ThreadBuffer
+	{
+		uint32_t m_ThreadId;
+		const char* m_ThreadName{ nullptr };
+		std::unique_ptr<Event[]> m_Events;
+		std::atomic<uint64_t> m_Written{ 0 };
+	};
+
+	//buffers are never freed, so events of threads that already exited can still be exported
+	std::mutex g_RegistryMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> g_Buffers;
+	const vkEngine::profiler::Clock::time_point g_Epoch = vkEngine::profiler::Clock::now();
+
+	//registration is the only place that locks, once per thread
+	ThreadBuffer& thread_buffer()
+	{
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (!buffer)
+		{
+			std::lock_guard<std::mutex> lock(g_RegistryMutex);
+			g_Buffers.push_back(std::make_unique<ThreadBuffer>());
+			buffer = g_Buffers.back().get();
+			buffer->m_ThreadId = (uint32_t)g_Buffers.size();
+			buffer->m_Events.reset(new Event[vkEngine::profiler::EVENTS_PER_THREAD]);
+		}
+		return *buffer;
+	}
+
+	int64_t to_ns(vkEngine::profiler::Clock::duration duration)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+	}
+
+}
+
+void vkEngine::profiler::set_thread_name(const char* name)
+{
+	thread_buffer().m_ThreadName = name;
+}
+
+void vkEngine::profiler::record(const char* name, Clock::time_point start, Clock::time_point end)
+{
+	ThreadBuffer& buffer = thread_buffer();
+
+	uint64_t index = buffer.m_Written.load(std::memory_order_relaxed);
+	buffer.m_Events[index % EVENTS_PER_THREAD] = { name, to_ns(start - g_Epoch), to_ns(end - start) };
+	buffer.m_Written.store(index + 1, std::memory_order_release);
+}
+
+bool vkEngine::profiler::write_chrome_trace(const std::string& path)
+{
+#ifndef ENGINE_PROFILING
+	(void)path;
+	std::cout << "Built without ENGINE_PROFILING, there is no trace to write" << std::endl;
+	return false;
+#else
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write the trace to " << path << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+	uint64_t eventCount = 0;
+	bool first = true;
+	auto separator = [&]() -> const char* {
+		const char* result = first ? "\n" : ",\n";
+		first = false;
+		return result;
+	};
+
+	//event names are identifiers chosen by the engine, nothing in them needs escaping
+	//fixed nanosecond precision, the default formatting switches to exponents for long runs
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[";
+	for (const std::unique_ptr<ThreadBuffer>& buffer : g_Buffers)
+	{
+		if (buffer->m_ThreadName)
+		{
+			file << separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->m_ThreadId
+				<< ",\"args\":{\"name\":\"" << buffer->m_ThreadName << "\"}}";
+		}
+
+		uint64_t written = buffer->m_Written.load(std::memory_order_acquire);
+		uint64_t begin = written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0;
+		for (uint64_t i = begin; i < written; i++)
+		{
+			const Event& event = buffer->m_Events[i % EVENTS_PER_THREAD];
+			//complete events, timestamps in microseconds
+			file << separator() << "{\"name\":\"" << event.m_Name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->m_ThreadId
+				<< ",\"ts\":" << event.m_StartNs / 1000.0 << ",\"dur\":" << event.m_DurationNs / 1000.0 << "}";
+		}
+		eventCount += written - begin;
+	}
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	std::cout << "Wrote " << eventCount << " trace events to " << path << std::endl;
+	return true;
+#endif
+}
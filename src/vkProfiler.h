@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+//instrumentation scopes, compiled in when ENGINE_PROFILING is defined (see the ENGINE_PROFILING CMake option).
+//without it the macros expand to nothing and cost nothing
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef ENGINE_PROFILING
+//times the rest of the enclosing block
+#define PROFILE_SCOPE(name) vkEngine::profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+//records an interval that was measured elsewhere
+#define PROFILE_EVENT(name, start, end) vkEngine::profiler::record(name, start, end)
+#define PROFILE_THREAD_NAME(name) vkEngine::profiler::set_thread_name(name)
+#else
+//the arguments are still evaluated as void, so nothing computed only for the profiler ends up unused
+#define PROFILE_SCOPE(name) do { (void)(name); } while (0)
+#define PROFILE_EVENT(name, start, end) do { (void)(name); (void)(start); (void)(end); } while (0)
+#define PROFILE_THREAD_NAME(name) do { (void)(name); } while (0)
+#endif
+
+namespace vkEngine {
+
+	namespace profiler {
+
+		using Clock = std::chrono::steady_clock;
+
+		//events kept per thread, older ones are overwritten once a thread recorded more
+		constexpr uint32_t EVENTS_PER_THREAD = 1 << 16;
+
+		//shown as the thread's name in the trace, the string must outlive the profiler
+		void set_thread_name(const char* name);
+
+		//appends to the calling thread's ring, without locks. names must be string literals or otherwise outlive the profiler
+		void record(const char* name, Clock::time_point start, Clock::time_point end);
+
+		//writes every recorded event as Chrome trace JSON, loadable in chrome://tracing and Perfetto.
+		//call once the threads that record have stopped. Returns false if nothing could be written
+		bool write_chrome_trace(const std::string& path);
+
+		class Scope
+		{
+		public:
+			explicit Scope(const char* name) : m_Name(name), m_Start(Clock::now()) {}
+			~Scope() { record(m_Name, m_Start, Clock::now()); }
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			const char* m_Name;
+			Clock::time_point m_Start;
+		};
+
+	}
+
+}
@@ -0,0 +1,251 @@
+#include <vkShaderCache.h>
+#include <vkEmbeddedShaders.h>
+#include <vkProfiler.h>
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+vkEngine::MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+vkEngine::MappedFile& vkEngine::MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		m_Data = other.m_Data;
+		m_Size = other.m_Size;
+		other.m_Data = nullptr;
+		other.m_Size = 0;
+#ifdef _WIN32
+		m_Mapping = other.m_Mapping;
+		other.m_Mapping = nullptr;
+#endif
+	}
+	return *this;
+}
+
+bool vkEngine::MappedFile::open(const char* path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	//the mapping keeps the file referenced, the file handle is not needed anymore
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+
+	m_Mapping = mapping;
+	m_Data = data;
+	m_Size = (size_t)fileSize.QuadPart;
+#else
+	int file = ::open(path, O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	//the mapping stays valid after the descriptor is closed
+	void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_Data = data;
+	m_Size = (size_t)fileStat.st_size;
+#endif
+	return true;
+}
+
+void vkEngine::MappedFile::close()
+{
+	if (!m_Data)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_Data);
+	CloseHandle(m_Mapping);
+	m_Mapping = nullptr;
+#else
+	munmap(m_Data, m_Size);
+#endif
+	m_Data = nullptr;
+	m_Size = 0;
+}
+
+void vkEngine::ShaderCache::init(VkDevice device)
+{
+	m_Device = device;
+}
+
+void vkEngine::ShaderCache::destroy()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	for (auto& entry : m_Modules)
+		vkDestroyShaderModule(m_Device, entry.second.m_Module, nullptr);
+	for (VkShaderModule shaderModule : m_CollidedModules)
+		vkDestroyShaderModule(m_Device, shaderModule, nullptr);
+
+	m_Modules.clear();
+	m_CollidedModules.clear();
+	m_Reflections.clear();
+	m_Prefetched.clear();
+}
+
+uint64_t vkEngine::ShaderCache::hash_code(const void* data, size_t size)
+{
+	//FNV-1a over the words, SPIR-V is always a whole number of them
+	const uint32_t* words = (const uint32_t*)data;
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size / sizeof(uint32_t); i++)
+	{
+		hash ^= words[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+void vkEngine::ShaderCache::prefetch(const char* path)
+{
+	PROFILE_SCOPE("ShaderCache::prefetch");
+
+	if (m_UseEmbedded && find_embedded_shader(path))
+		return;
+
+	Prefetched prefetched;
+	if (!prefetched.m_File.open(path))
+		return;
+
+	//hashing touches every page, so get() finds the file resident
+	prefetched.m_Hash = hash_code(prefetched.m_File.data(), prefetched.m_File.size());
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Prefetched[path] = std::move(prefetched);
+}
+
+VkShaderModule vkEngine::ShaderCache::get(const char* path)
+{
+	PROFILE_SCOPE("ShaderCache::get");
+
+	//already in memory, no file is touched
+	if (m_UseEmbedded)
+	{
+		if (const EmbeddedShader* embedded = find_embedded_shader(path))
+			return get_or_create(hash_code(embedded->m_Code, embedded->m_Size), embedded->m_Code, embedded->m_Size);
+	}
+
+	return get_from_file(path);
+}
+
+VkShaderModule vkEngine::ShaderCache::get_from_file(const char* path)
+{
+	MappedFile file;
+	uint64_t hash = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto prefetched = m_Prefetched.find(path);
+		if (prefetched != m_Prefetched.end())
+		{
+			file = std::move(prefetched->second.m_File);
+			hash = prefetched->second.m_Hash;
+			m_Prefetched.erase(prefetched);
+		}
+	}
+
+	if (!file.data())
+	{
+		if (!file.open(path))
+			return VK_NULL_HANDLE;
+		hash = hash_code(file.data(), file.size());
+	}
+
+	//a SPIR-V module starts with a five word header
+	if (file.size() % sizeof(uint32_t) != 0 || file.size() < 5 * sizeof(uint32_t))
+	{
+		std::cout << path << " is not a SPIR-V module" << std::endl;
+		return VK_NULL_HANDLE;
+	}
+
+	//the mapping is page aligned, so the driver can read the code straight from it
+	return get_or_create(hash, (const uint32_t*)file.data(), file.size());
+}
+
+VkShaderModule vkEngine::ShaderCache::get_or_create(uint64_t hash, const uint32_t* code, size_t size)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	auto existing = m_Modules.find(hash);
+	if (existing != m_Modules.end() && existing->second.m_CodeSize == size)
+	{
+		m_Hits++;
+		return existing->second.m_Module;
+	}
+
+	VkShaderModuleCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.pNext = nullptr;
+
+	createInfo.codeSize = size;
+	createInfo.pCode = code;
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(m_Device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+
+	//the code is only at hand here, files are unmapped once get() returns
+	ShaderReflection reflection;
+	if (reflect_spirv(code, size, reflection))
+		m_Reflections[shaderModule] = std::move(reflection);
+
+	//on a collision the first module keeps the slot, the other one is still owned by the cache
+	if (existing != m_Modules.end())
+		m_CollidedModules.push_back(shaderModule);
+	else
+		m_Modules[hash] = { shaderModule, size };
+	return shaderModule;
+}
+
+const vkEngine::ShaderReflection* vkEngine::ShaderCache::get_reflection(VkShaderModule shaderModule)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	auto reflection = m_Reflections.find(shaderModule);
+	return reflection != m_Reflections.end() ? &reflection->second : nullptr;
+}
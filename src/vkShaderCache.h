@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vkTypes.h>
+#include <vkShaderReflection.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vkEngine {
+
+	//read-only memory mapping of a whole file, unmapped when closed or destroyed
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile() { close(); }
+
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		//Returns false if the file can not be opened or is empty
+		bool open(const char* path);
+		void close();
+
+		const void* data() const { return m_Data; }
+		size_t size() const { return m_Size; }
+
+	private:
+		void* m_Data{ nullptr };
+		size_t m_Size{ 0 };
+#ifdef _WIN32
+		void* m_Mapping{ nullptr };
+#endif
+	};
+
+	//shader modules keyed by a hash of their SPIR-V. code embedded into the executable is used before files on disk,
+	//files are mapped and handed to the driver without a copy, and identical code loaded from any path shares one module.
+	//modules live until destroy()
+	class ShaderCache
+	{
+	public:
+		void init(VkDevice device);
+
+		//off always reads the files on disk, e.g. to pick up shaders recompiled after the build
+		void set_use_embedded(bool useEmbedded) { m_UseEmbedded = useEmbedded; }
+
+		//destroys every module
+		void destroy();
+
+		//maps and hashes the file ahead of get(), needs no device. meant for the init graph, does nothing for embedded shaders
+		void prefetch(const char* path);
+
+		//the module for the embedded copy of the file or its current contents, created on first use.
+		//VK_NULL_HANDLE if the file is missing or invalid
+		VkShaderModule get(const char* path);
+
+		//same as get() but always reads the file, for shaders recompiled while running
+		VkShaderModule get_from_file(const char* path);
+
+		//what the module's code declares, read once when the module was created. nullptr if reflection failed
+		const ShaderReflection* get_reflection(VkShaderModule shaderModule);
+
+		size_t size() const { return m_Modules.size(); }
+		uint64_t get_hit_count() const { return m_Hits; }
+
+	private:
+		struct Prefetched
+		{
+			MappedFile m_File;
+			uint64_t m_Hash;
+		};
+
+		struct Module
+		{
+			VkShaderModule m_Module;
+			//guards against the unlikely 64-bit hash collision between files of different sizes
+			size_t m_CodeSize;
+		};
+
+		static uint64_t hash_code(const void* data, size_t size);
+
+		//expects the code to be validated already
+		VkShaderModule get_or_create(uint64_t hash, const uint32_t* code, size_t size);
+
+		VkDevice m_Device{ VK_NULL_HANDLE };
+		bool m_UseEmbedded{ true };
+
+		//the engine loads shaders from the init graph and from worker threads
+		std::mutex m_Mutex;
+		std::unordered_map<std::string, Prefetched> m_Prefetched;
+		std::unordered_map<uint64_t, Module> m_Modules;
+		std::vector<VkShaderModule> m_CollidedModules;
+		//elements never move, pointers handed out stay valid until destroy()
+		std::unordered_map<VkShaderModule, ShaderReflection> m_Reflections;
+		uint64_t m_Hits{ 0 };
+	};
+
+}
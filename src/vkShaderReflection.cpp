@@ -0,0 +1,372 @@
+#include <vkShaderReflection.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+	//the few parts of the SPIR-V grammar reflection needs
+	enum Op : uint32_t
+	{
+		OP_ENTRY_POINT = 15,
+		OP_TYPE_INT = 21,
+		OP_TYPE_FLOAT = 22,
+		OP_TYPE_VECTOR = 23,
+		OP_TYPE_MATRIX = 24,
+		OP_TYPE_IMAGE = 25,
+		OP_TYPE_SAMPLER = 26,
+		OP_TYPE_SAMPLED_IMAGE = 27,
+		OP_TYPE_ARRAY = 28,
+		OP_TYPE_RUNTIME_ARRAY = 29,
+		OP_TYPE_STRUCT = 30,
+		OP_TYPE_POINTER = 32,
+		OP_CONSTANT = 43,
+		OP_VARIABLE = 59,
+		OP_DECORATE = 71,
+		OP_MEMBER_DECORATE = 72,
+	};
+
+	enum Decoration : uint32_t
+	{
+		DECORATION_BUFFER_BLOCK = 3,
+		DECORATION_ARRAY_STRIDE = 6,
+		DECORATION_MATRIX_STRIDE = 7,
+		DECORATION_BINDING = 33,
+		DECORATION_DESCRIPTOR_SET = 34,
+		DECORATION_OFFSET = 35,
+	};
+
+	enum StorageClass : uint32_t
+	{
+		STORAGE_UNIFORM_CONSTANT = 0,
+		STORAGE_UNIFORM = 2,
+		STORAGE_PUSH_CONSTANT = 9,
+		STORAGE_STORAGE_BUFFER = 12,
+	};
+
+	enum Dim : uint32_t
+	{
+		DIM_BUFFER = 5,
+		DIM_SUBPASS_DATA = 6,
+	};
+
+	struct Type
+	{
+		uint32_t m_Op{ 0 };
+		//the instruction's operands after the result id
+		std::vector<uint32_t> m_Operands;
+	};
+
+	struct Member
+	{
+		uint32_t m_Offset{ 0 };
+		uint32_t m_MatrixStride{ 0 };
+	};
+
+	struct Id
+	{
+		Type m_Type;
+		uint32_t m_Constant{ 0 };
+		uint32_t m_Set{ 0 };
+		uint32_t m_Binding{ 0 };
+		bool m_HasBinding{ false };
+		bool m_BufferBlock{ false };
+		uint32_t m_ArrayStride{ 0 };
+		std::vector<Member> m_Members;
+	};
+
+	struct Variable
+	{
+		uint32_t m_Id;
+		uint32_t m_PointerType;
+		uint32_t m_StorageClass;
+	};
+
+	class Module
+	{
+	public:
+		std::vector<Id> m_Ids;
+
+		//operands are not validated while parsing, ids past the bound read as an empty id
+		const Id& id(uint32_t index) const
+		{
+			static const Id empty;
+			return index < m_Ids.size() ? m_Ids[index] : empty;
+		}
+
+		const Type& type(uint32_t index) const { return id(index).m_Type; }
+
+		Member& member(uint32_t structId, uint32_t index)
+		{
+			std::vector<Member>& members = m_Ids[structId].m_Members;
+			if (members.size() <= index)
+				members.resize(index + 1);
+			return members[index];
+		}
+
+		//byte size of a type inside an explicitly laid out block
+		uint32_t size_of(uint32_t typeId, uint32_t matrixStride) const
+		{
+			const Type& t = type(typeId);
+			if (t.m_Operands.empty())
+				return 0;
+
+			switch (t.m_Op)
+			{
+			case OP_TYPE_INT:
+			case OP_TYPE_FLOAT:
+				return t.m_Operands[0] / 8;
+			case OP_TYPE_VECTOR:
+				return t.m_Operands.size() < 2 ? 0 : size_of(t.m_Operands[0], 0) * t.m_Operands[1];
+			case OP_TYPE_MATRIX:
+				//column major, each column is matrixStride apart
+				return t.m_Operands.size() < 2 ? 0 : matrixStride * t.m_Operands[1];
+			case OP_TYPE_ARRAY:
+				return t.m_Operands.size() < 2 ? 0 : id(typeId).m_ArrayStride * id(t.m_Operands[1]).m_Constant;
+			case OP_TYPE_STRUCT:
+			{
+				uint32_t size = 0;
+				const std::vector<Member>& members = id(typeId).m_Members;
+				for (uint32_t i = 0; i < t.m_Operands.size() && i < members.size(); i++)
+					size = std::max(size, members[i].m_Offset + size_of(t.m_Operands[i], members[i].m_MatrixStride));
+				return size;
+			}
+			default:
+				return 0;
+			}
+		}
+	};
+
+	bool descriptor_type_of(const Module& module, uint32_t typeId, uint32_t storageClass, VkDescriptorType& outType)
+	{
+		const Type& t = module.type(typeId);
+
+		if (storageClass == STORAGE_STORAGE_BUFFER)
+		{
+			outType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			return true;
+		}
+		if (storageClass == STORAGE_UNIFORM)
+		{
+			//old style storage buffers are uniform blocks decorated as BufferBlock
+			outType = module.id(typeId).m_BufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			return true;
+		}
+
+		switch (t.m_Op)
+		{
+		case OP_TYPE_SAMPLER:
+			outType = VK_DESCRIPTOR_TYPE_SAMPLER;
+			return true;
+		case OP_TYPE_SAMPLED_IMAGE:
+			outType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			return true;
+		case OP_TYPE_IMAGE:
+		{
+			if (t.m_Operands.size() < 6)
+				return false;
+
+			//operands: sampled type, dim, depth, arrayed, multisampled, sampled, format
+			uint32_t dim = t.m_Operands[1];
+			bool sampled = t.m_Operands[5] == 1;
+			if (dim == DIM_SUBPASS_DATA)
+				outType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			else if (dim == DIM_BUFFER)
+				outType = sampled ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+			else
+				outType = sampled ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+
+	bool stage_of(uint32_t executionModel, VkShaderStageFlagBits& outStage)
+	{
+		switch (executionModel)
+		{
+		case 0: outStage = VK_SHADER_STAGE_VERTEX_BIT; return true;
+		case 1: outStage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT; return true;
+		case 2: outStage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT; return true;
+		case 3: outStage = VK_SHADER_STAGE_GEOMETRY_BIT; return true;
+		case 4: outStage = VK_SHADER_STAGE_FRAGMENT_BIT; return true;
+		case 5: outStage = VK_SHADER_STAGE_COMPUTE_BIT; return true;
+		default: return false;
+		}
+	}
+
+}
+
+bool vkEngine::reflect_spirv(const uint32_t* code, size_t size, ShaderReflection& outReflection)
+{
+	outReflection = ShaderReflection{};
+
+	size_t wordCount = size / sizeof(uint32_t);
+	if (wordCount < 5 || code[0] != 0x07230203)
+	{
+		std::cout << "Reflection: not a SPIR-V module" << std::endl;
+		return false;
+	}
+
+	//the header's id bound covers every id in the module
+	uint32_t bound = code[3];
+	Module module;
+	module.m_Ids.resize(bound);
+
+	std::vector<Variable> variables;
+	bool hasEntryPoint = false;
+
+	auto valid_id = [bound](uint32_t id) { return id < bound; };
+
+	for (size_t offset = 5; offset < wordCount;)
+	{
+		uint32_t opcode = code[offset] & 0xffff;
+		uint32_t count = code[offset] >> 16;
+		if (count == 0 || offset + count > wordCount)
+		{
+			std::cout << "Reflection: truncated instruction" << std::endl;
+			return false;
+		}
+		const uint32_t* operands = code + offset + 1;
+		uint32_t operandCount = count - 1;
+		offset += count;
+
+		switch (opcode)
+		{
+		case OP_ENTRY_POINT:
+			//the engine only ever uses one entry point per module, the first one decides the stage
+			if (!hasEntryPoint && operandCount >= 1)
+			{
+				if (!stage_of(operands[0], outReflection.m_Stage))
+				{
+					std::cout << "Reflection: unsupported execution model " << operands[0] << std::endl;
+					return false;
+				}
+				hasEntryPoint = true;
+			}
+			break;
+		case OP_TYPE_INT:
+		case OP_TYPE_FLOAT:
+		case OP_TYPE_VECTOR:
+		case OP_TYPE_MATRIX:
+		case OP_TYPE_IMAGE:
+		case OP_TYPE_SAMPLER:
+		case OP_TYPE_SAMPLED_IMAGE:
+		case OP_TYPE_ARRAY:
+		case OP_TYPE_RUNTIME_ARRAY:
+		case OP_TYPE_STRUCT:
+		case OP_TYPE_POINTER:
+			if (operandCount >= 1 && valid_id(operands[0]))
+			{
+				Type& t = module.m_Ids[operands[0]].m_Type;
+				t.m_Op = opcode;
+				t.m_Operands.assign(operands + 1, operands + operandCount);
+			}
+			break;
+		case OP_CONSTANT:
+			//array lengths are 32-bit integer constants
+			if (operandCount >= 3 && valid_id(operands[1]))
+				module.m_Ids[operands[1]].m_Constant = operands[2];
+			break;
+		case OP_VARIABLE:
+			if (operandCount >= 3 && valid_id(operands[1]))
+				variables.push_back({ operands[1], operands[0], operands[2] });
+			break;
+		case OP_DECORATE:
+			if (operandCount >= 2 && valid_id(operands[0]))
+			{
+				Id& id = module.m_Ids[operands[0]];
+				uint32_t value = operandCount >= 3 ? operands[2] : 0;
+				if (operands[1] == DECORATION_DESCRIPTOR_SET)
+					id.m_Set = value;
+				else if (operands[1] == DECORATION_BINDING)
+				{
+					id.m_Binding = value;
+					id.m_HasBinding = true;
+				}
+				else if (operands[1] == DECORATION_BUFFER_BLOCK)
+					id.m_BufferBlock = true;
+				else if (operands[1] == DECORATION_ARRAY_STRIDE)
+					id.m_ArrayStride = value;
+			}
+			break;
+		case OP_MEMBER_DECORATE:
+			if (operandCount >= 4 && valid_id(operands[0]))
+			{
+				if (operands[2] == DECORATION_OFFSET)
+					module.member(operands[0], operands[1]).m_Offset = operands[3];
+				else if (operands[2] == DECORATION_MATRIX_STRIDE)
+					module.member(operands[0], operands[1]).m_MatrixStride = operands[3];
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (!hasEntryPoint)
+	{
+		std::cout << "Reflection: module has no entry point" << std::endl;
+		return false;
+	}
+
+	for (const Variable& variable : variables)
+	{
+		if (variable.m_StorageClass != STORAGE_UNIFORM_CONSTANT && variable.m_StorageClass != STORAGE_UNIFORM
+			&& variable.m_StorageClass != STORAGE_PUSH_CONSTANT && variable.m_StorageClass != STORAGE_STORAGE_BUFFER)
+			continue;
+
+		//variables are always pointers, look through to what they point at
+		const Type& pointer = module.type(variable.m_PointerType);
+		if (pointer.m_Op != OP_TYPE_POINTER || pointer.m_Operands.size() < 2)
+			continue;
+		uint32_t typeId = pointer.m_Operands[1];
+
+		if (variable.m_StorageClass == STORAGE_PUSH_CONSTANT)
+		{
+			outReflection.m_PushConstantSize = std::max(outReflection.m_PushConstantSize, module.size_of(typeId, 0));
+			continue;
+		}
+
+		//arrays of descriptors take one binding with a count
+		uint32_t descriptorCount = 1;
+		while (module.type(typeId).m_Op == OP_TYPE_ARRAY || module.type(typeId).m_Op == OP_TYPE_RUNTIME_ARRAY)
+		{
+			const Type& array = module.type(typeId);
+			if (array.m_Op == OP_TYPE_RUNTIME_ARRAY)
+			{
+				std::cout << "Reflection: unsized descriptor arrays need descriptor indexing, which the engine does not enable" << std::endl;
+				return false;
+			}
+			if (array.m_Operands.size() < 2)
+				return false;
+			descriptorCount *= module.id(array.m_Operands[1]).m_Constant;
+			typeId = array.m_Operands[0];
+		}
+
+		const Id& id = module.id(variable.m_Id);
+		if (!id.m_HasBinding)
+			continue;
+
+		VkDescriptorSetLayoutBinding binding = {};
+		binding.binding = id.m_Binding;
+		binding.descriptorCount = descriptorCount;
+		binding.stageFlags = outReflection.m_Stage;
+		binding.pImmutableSamplers = nullptr;
+
+		if (!descriptor_type_of(module, typeId, variable.m_StorageClass, binding.descriptorType))
+		{
+			std::cout << "Reflection: unsupported resource at set " << id.m_Set << " binding " << id.m_Binding << std::endl;
+			return false;
+		}
+
+		outReflection.m_Bindings.push_back({ id.m_Set, binding });
+	}
+
+	//the same order no matter how the compiler laid out the variables
+	std::sort(outReflection.m_Bindings.begin(), outReflection.m_Bindings.end(), [](const ReflectedBinding& a, const ReflectedBinding& b) {
+		return a.m_Set != b.m_Set ? a.m_Set < b.m_Set : a.m_Binding.binding < b.m_Binding.binding;
+	});
+	return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vkTypes.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vkEngine {
+
+	//a descriptor a shader declares, stageFlags is the stage of the module it was found in
+	struct ReflectedBinding
+	{
+		uint32_t m_Set;
+		VkDescriptorSetLayoutBinding m_Binding;
+	};
+
+	//the resources one SPIR-V module uses
+	struct ShaderReflection
+	{
+		VkShaderStageFlagBits m_Stage{ VK_SHADER_STAGE_ALL };
+		std::vector<ReflectedBinding> m_Bindings;
+		//size of the push constant block, 0 if the module has none
+		uint32_t m_PushConstantSize{ 0 };
+	};
+
+	//reads the entry point stage, the descriptor bindings and the push constant block out of SPIR-V.
+	//Returns false for code it can not make sense of, or resources the engine has no layout for
+	bool reflect_spirv(const uint32_t* code, size_t size, ShaderReflection& outReflection);
+
+}
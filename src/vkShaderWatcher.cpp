@@ -0,0 +1,148 @@
+#include <vkShaderWatcher.h>
+#include <vkProfiler.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <set>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	//how often the watcher thread checks whether it should stop
+	constexpr int POLL_INTERVAL_MS = 100;
+	//editors save in several writes and renames, changes are collected this long before compiling
+	constexpr int SETTLE_TIME_MS = 50;
+
+	bool is_glsl_source(const char* name)
+	{
+		static const char* const EXTENSIONS[] = { ".vert", ".frag", ".comp", ".geom", ".tesc", ".tese" };
+
+		const char* extension = strrchr(name, '.');
+		if (!extension)
+			return false;
+		for (const char* glslExtension : EXTENSIONS)
+		{
+			if (strcmp(extension, glslExtension) == 0)
+				return true;
+		}
+		return false;
+	}
+
+}
+
+bool vkEngine::ShaderWatcher::start(const std::string& directory, const std::string& compiler, CompiledCallback&& onCompiled)
+{
+	stop();
+
+#ifdef __linux__
+	m_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_Inotify < 0)
+	{
+		std::cout << "Failed to create the inotify instance for shader hot reload" << std::endl;
+		return false;
+	}
+
+	//writes in place and files moved over the old ones, the way most editors save
+	if (inotify_add_watch(m_Inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		std::cout << "Failed to watch " << directory << " for shader changes" << std::endl;
+		close(m_Inotify);
+		m_Inotify = -1;
+		return false;
+	}
+
+	m_Directory = directory;
+	m_Compiler = compiler;
+	m_OnCompiled = std::move(onCompiled);
+	m_Stop = false;
+	m_Thread = std::thread(&ShaderWatcher::watch_loop, this);
+	return true;
+#else
+	(void)directory;
+	(void)compiler;
+	(void)onCompiled;
+	std::cout << "Shader hot reload needs inotify, it is only available on Linux" << std::endl;
+	return false;
+#endif
+}
+
+void vkEngine::ShaderWatcher::stop()
+{
+	if (!m_Thread.joinable())
+		return;
+
+	m_Stop = true;
+	m_Thread.join();
+
+#ifdef __linux__
+	close(m_Inotify);
+#endif
+	m_Inotify = -1;
+}
+
+void vkEngine::ShaderWatcher::watch_loop()
+{
+#ifdef __linux__
+	PROFILE_THREAD_NAME("shader_watcher");
+
+	alignas(inotify_event) char buffer[4096];
+	std::set<std::string> changed;
+
+	while (!m_Stop)
+	{
+		//wait for the first change, then give the editor a moment to finish writing
+		pollfd pollInfo = { m_Inotify, POLLIN, 0 };
+		int timeout = changed.empty() ? POLL_INTERVAL_MS : SETTLE_TIME_MS;
+		int ready = poll(&pollInfo, 1, timeout);
+
+		if (ready > 0)
+		{
+			ssize_t length;
+			while ((length = read(m_Inotify, buffer, sizeof(buffer))) > 0)
+			{
+				for (char* event = buffer; event < buffer + length;)
+				{
+					const inotify_event* info = (const inotify_event*)event;
+					if (info->len > 0 && is_glsl_source(info->name))
+						changed.insert(info->name);
+					event += sizeof(inotify_event) + info->len;
+				}
+			}
+			continue;
+		}
+
+		if (changed.empty())
+			continue;
+
+		for (const std::string& name : changed)
+		{
+			std::string source = m_Directory + "/" + name;
+			std::string output = source + ".spv";
+			if (compile(source, output))
+				m_OnCompiled(output);
+		}
+		changed.clear();
+	}
+#endif
+}
+
+bool vkEngine::ShaderWatcher::compile(const std::string& source, const std::string& output)
+{
+	PROFILE_SCOPE("ShaderWatcher::compile");
+
+	//the compiler prints its own errors
+	std::string command = "\"" + m_Compiler + "\" -V \"" + source + "\" -o \"" + output + "\"";
+	int result = std::system(command.c_str());
+	if (result != 0)
+	{
+		std::cout << "Failed to compile " << source << ", keeping the previous shader" << std::endl;
+		return false;
+	}
+	return true;
+}
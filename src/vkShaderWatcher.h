@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace vkEngine {
+
+	//watches a directory of GLSL sources and recompiles every file that changes with glslangValidator,
+	//next to the source as <name>.spv the way the build does. watching and compiling happen on one background thread.
+	//only implemented with inotify, start() fails on other platforms
+	class ShaderWatcher
+	{
+	public:
+		//called on the watcher thread with the path of the freshly written SPIR-V
+		using CompiledCallback = std::function<void(const std::string& spirvPath)>;
+
+		~ShaderWatcher() { stop(); }
+
+		//Returns false if the directory can not be watched
+		bool start(const std::string& directory, const std::string& compiler, CompiledCallback&& onCompiled);
+
+		//joins the thread, a compile that is running is finished first
+		void stop();
+
+		bool is_running() const { return m_Thread.joinable(); }
+
+	private:
+		void watch_loop();
+
+		//Returns false if the compiler could not be run or rejected the source
+		bool compile(const std::string& source, const std::string& output);
+
+		std::string m_Directory;
+		std::string m_Compiler;
+		CompiledCallback m_OnCompiled;
+
+		std::thread m_Thread;
+		std::atomic<bool> m_Stop{ false };
+		int m_Inotify{ -1 };
+	};
+
+}
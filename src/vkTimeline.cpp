@@ -0,0 +1,118 @@
+#include <vkTimeline.h>
+
+#include <cassert>
+#include <iostream>
+
+void vkEngine::TimelineSemaphore::init(VkDevice device, uint64_t initialValue)
+{
+	m_Device = device;
+
+	VkSemaphoreTypeCreateInfo typeInfo = {};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.pNext = nullptr;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = initialValue;
+
+	VkSemaphoreCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	createInfo.pNext = &typeInfo;
+	createInfo.flags = 0;
+
+	if (vkCreateSemaphore(m_Device, &createInfo, nullptr, &m_Semaphore) != VK_SUCCESS)
+	{
+		std::cout << "Failed to create timeline semaphore" << std::endl;
+		abort();
+	}
+
+	m_LastSubmitted = initialValue;
+	m_CompletedCache = initialValue;
+}
+
+void vkEngine::TimelineSemaphore::destroy()
+{
+	vkDestroySemaphore(m_Device, m_Semaphore, nullptr);
+	m_Semaphore = VK_NULL_HANDLE;
+}
+
+uint64_t vkEngine::TimelineSemaphore::completed_value()
+{
+	uint64_t value = 0;
+	if (vkGetSemaphoreCounterValue(m_Device, m_Semaphore, &value) != VK_SUCCESS)
+		return m_CompletedCache;
+
+	//several threads may poll at once, never let the cache go backwards
+	uint64_t cached = m_CompletedCache.load();
+	while (cached < value && !m_CompletedCache.compare_exchange_weak(cached, value)) {}
+
+	return value;
+}
+
+bool vkEngine::TimelineSemaphore::is_complete(uint64_t value)
+{
+	if (value <= m_CompletedCache.load())
+		return true;
+
+	return value <= completed_value();
+}
+
+bool vkEngine::TimelineSemaphore::wait(uint64_t value, uint64_t timeout)
+{
+	if (is_complete(value))
+		return true;
+
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.pNext = nullptr;
+	waitInfo.flags = 0;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &m_Semaphore;
+	waitInfo.pValues = &value;
+
+	VkResult result = vkWaitSemaphores(m_Device, &waitInfo, timeout);
+	if (result == VK_TIMEOUT)
+		return false;
+
+	if (result != VK_SUCCESS)
+	{
+		std::cout << "Detected Vulkan error while waiting on timeline: " << result << std::endl;
+		abort();
+	}
+
+	completed_value();
+	return true;
+}
+
+void vkEngine::SubmitSync::wait(VkSemaphore semaphore, VkPipelineStageFlags stage, uint64_t value)
+{
+	assert(m_WaitCount < MAX_SEMAPHORES);
+	m_WaitSemaphores[m_WaitCount] = semaphore;
+	m_WaitStages[m_WaitCount] = stage;
+	m_WaitValues[m_WaitCount] = value;
+	m_WaitCount++;
+}
+
+void vkEngine::SubmitSync::signal(VkSemaphore semaphore, uint64_t value)
+{
+	assert(m_SignalCount < MAX_SEMAPHORES);
+	m_SignalSemaphores[m_SignalCount] = semaphore;
+	m_SignalValues[m_SignalCount] = value;
+	m_SignalCount++;
+}
+
+void vkEngine::SubmitSync::apply(VkSubmitInfo& submit)
+{
+	m_TimelineInfo = {};
+	m_TimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	m_TimelineInfo.pNext = submit.pNext;
+	m_TimelineInfo.waitSemaphoreValueCount = m_WaitCount;
+	m_TimelineInfo.pWaitSemaphoreValues = m_WaitValues;
+	m_TimelineInfo.signalSemaphoreValueCount = m_SignalCount;
+	m_TimelineInfo.pSignalSemaphoreValues = m_SignalValues;
+
+	submit.pNext = &m_TimelineInfo;
+	submit.waitSemaphoreCount = m_WaitCount;
+	submit.pWaitSemaphores = m_WaitSemaphores;
+	submit.pWaitDstStageMask = m_WaitStages;
+	submit.signalSemaphoreCount = m_SignalCount;
+	submit.pSignalSemaphores = m_SignalSemaphores;
+}
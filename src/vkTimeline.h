@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vkTypes.h>
+#include <atomic>
+#include <cstdint>
+
+namespace vkEngine {
+
+	//monotonic GPU progress counter backed by a timeline semaphore.
+	//every submission that signals it gets a fresh value, and anyone can ask whether the GPU got that far
+	class TimelineSemaphore
+	{
+	public:
+		void init(VkDevice device, uint64_t initialValue = 0);
+		void destroy();
+
+		VkSemaphore get() const { return m_Semaphore; }
+
+		//reserves the value the next submission on this timeline will signal
+		uint64_t next_signal_value() { return ++m_LastSubmitted; }
+		//highest value handed out so far, the GPU reaches it once all queued work is done
+		uint64_t last_submitted_value() const { return m_LastSubmitted; }
+
+		//queries the semaphore and refreshes the cached completed value
+		uint64_t completed_value();
+		//cheap poll, only touches the driver when the cached value is behind
+		bool is_complete(uint64_t value);
+		//blocks until the GPU reached value, returns false on timeout
+		bool wait(uint64_t value, uint64_t timeout = UINT64_MAX);
+
+	private:
+		VkDevice m_Device{ VK_NULL_HANDLE };
+		VkSemaphore m_Semaphore{ VK_NULL_HANDLE };
+
+		std::atomic<uint64_t> m_LastSubmitted{ 0 };
+		std::atomic<uint64_t> m_CompletedCache{ 0 };
+	};
+
+	//semaphores of a single vkQueueSubmit. binary and timeline semaphores can be mixed,
+	//binary ones just carry a value the driver ignores so the timeline arrays line up
+	struct SubmitSync
+	{
+		static constexpr uint32_t MAX_SEMAPHORES = 4;
+
+		void wait(VkSemaphore semaphore, VkPipelineStageFlags stage, uint64_t value = 0);
+		void signal(VkSemaphore semaphore, uint64_t value = 0);
+
+		//points the wait/signal members of submit at our arrays and chains the timeline values into its pNext
+		void apply(VkSubmitInfo& submit);
+
+		VkSemaphore m_WaitSemaphores[MAX_SEMAPHORES];
+		VkPipelineStageFlags m_WaitStages[MAX_SEMAPHORES];
+		uint64_t m_WaitValues[MAX_SEMAPHORES];
+		uint32_t m_WaitCount{ 0 };
+
+		VkSemaphore m_SignalSemaphores[MAX_SEMAPHORES];
+		uint64_t m_SignalValues[MAX_SEMAPHORES];
+		uint32_t m_SignalCount{ 0 };
+
+		VkTimelineSemaphoreSubmitInfo m_TimelineInfo;
+	};
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace vkEngine {
+
+	//lock-free single producer, single consumer hand-off of the latest value.
+	//the writer fills its back slot and swaps it with the shared middle slot, the reader swaps the middle
+	//slot with its front slot whenever something new was published. neither side ever waits for the other,
+	//values the reader was too slow to pick up are simply replaced by newer ones
+	template<typename T>
+	class TripleBuffer
+	{
+	public:
+		//writer side, the returned slot is private to the writer until publish()
+		T& write_slot() { return m_Slots[m_BackIndex]; }
+
+		void publish()
+		{
+			uint8_t previous = m_Middle.exchange(m_BackIndex | NEW_DATA_BIT, std::memory_order_acq_rel);
+			m_BackIndex = previous & INDEX_MASK;
+		}
+
+		//reader side, returns true if a newer value than the current front slot was picked up
+		bool update()
+		{
+			if ((m_Middle.load(std::memory_order_relaxed) & NEW_DATA_BIT) == 0)
+				return false;
+
+			uint8_t previous = m_Middle.exchange(m_FrontIndex, std::memory_order_acq_rel);
+			m_FrontIndex = previous & INDEX_MASK;
+			return true;
+		}
+
+		//reader side, stays valid and unchanged until the next update()
+		const T& read_slot() const { return m_Slots[m_FrontIndex]; }
+
+	private:
+		static constexpr uint8_t INDEX_MASK = 0x3;
+		static constexpr uint8_t NEW_DATA_BIT = 0x4;
+
+		T m_Slots[3];
+
+		//the writer and reader indices live on their own cache lines so the two threads do not share one
+		alignas(64) std::atomic<uint8_t> m_Middle{ 1 };
+		alignas(64) uint8_t m_BackIndex{ 0 };
+		alignas(64) uint8_t m_FrontIndex{ 2 };
+	};
+
+}
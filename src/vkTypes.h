@@ -3,6 +3,20 @@
 
 #pragma once
 
-#include <vulkan/vulkan.h>
+//volk declares the Vulkan entry points as function pointers, loaded straight from the driver once the device exists
+#include <volk.h>
+#include <vk_mem_alloc.h>
 
-//we will add our main reusable types here
\ No newline at end of file
+//we will add our main reusable types here
+
+struct AllocatedImage
+{
+	VkImage m_Image;
+	VmaAllocation m_Allocation;
+};
+
+struct AllocatedBuffer
+{
+	VkBuffer m_Buffer;
+	VmaAllocation m_Allocation;
+};